@@ -1,7 +1,11 @@
 #pragma once
 
+#include <ECS/TagMask.h>
+
 namespace Editor
 {
     /// @brief Mark an entity is renaming
     struct Renaming{};
-}
\ No newline at end of file
+}
+
+template<> struct Spark::TagTraits<Editor::Renaming> : Spark::BitmaskTag {};
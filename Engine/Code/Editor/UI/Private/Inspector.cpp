@@ -174,7 +174,7 @@ namespace Editor
             {
                 context.Remove<SelectTag>(ent);
             }
-            scene->PatchEntityHierarchy(entity, [&](Entity ent){
+            scene->ForEachInSubtree(entity, [&](Entity ent){
                 if (!context.Has<SelectTag>(ent))
                 {
                     context.Add<SelectTag>(ent);
@@ -198,7 +198,7 @@ namespace Editor
         ImGui::Spacing();
         if (ImGui::MenuItem("Delete Hierarchy"))
         {
-            scene->PatchEntityHierarchy(entity, [&](Entity ent){
+            scene->ForEachInSubtree(entity, [&](Entity ent){
                 if (!context.Has<DeadTag>(ent))
                 {
                     context.Add<DeadTag>(ent);
@@ -305,7 +305,7 @@ namespace Editor
                     nodeStack.emplace(eastl::make_unique<EntityNode>(cur, context));
                     if (nodeStack.top()->IsOpen())
                     {
-                        eastl::vector<Entity> children = scene->GetChildren(cur);
+                        auto children = scene->GetChildrenView(cur);
                         for (auto it = children.rbegin(); it != children.rend(); ++it)
                         {
                             stack.emplace(*it, curDepth + 1);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <ECS/TagMask.h>
+
 namespace Spark
 {
     /// @brief Mark an entity will be destoryed
@@ -10,4 +12,9 @@ namespace Spark
 
     /// @brief Mark an entity has been seleted
     struct SelectTag{};
-}
\ No newline at end of file
+
+    // 在WorldContext的位掩码中记录，Has不再查询tag的storage
+    template<> struct TagTraits<DeadTag> : BitmaskTag {};
+    template<> struct TagTraits<ActiveTag> : BitmaskTag {};
+    template<> struct TagTraits<SelectTag> : BitmaskTag {};
+}
@@ -10,6 +10,8 @@
 #include "Private/CallstackEntry.h"
 #include "Private/Polices.h"
 #include "Private/EBusImpl.h"
+#include "Private/HandlerSnapshot.h"
+#include "Private/PerThreadQueue.h"
 
 namespace Spark
 {
@@ -36,6 +38,14 @@ namespace Spark
 
         using BusHandlerOrderCompare = BusHandlerCompareDefault;
 
+        /*
+        * With EBusHandlerPolicy::MultipleAndOrdered, set a sortable key type and define
+        *   static BusHandlerOrderKey GetHandlerOrderKey(const Interface* handler);
+        * to order the handlers by a key read once on connect instead of calling BusHandlerOrderCompare on every insert.
+        * The key is not read again, reconnect the handler if its order changes.
+        */
+        using BusHandlerOrderKey = void;
+
         using MutexType = NullMutex;
 
         static constexpr bool EnableEventQueue = false;
@@ -44,7 +54,29 @@ namespace Spark
 
         using EventQueueMutexType = NullMutex;
 
+        /*
+        * How queued events are stored. PerThread and PerThreadOrdered give every producing thread its own queue, so
+        * QueueBroadcast/QueueEvent from worker threads do not contend on EventQueueMutexType.
+        */
+        static constexpr EBusEventQueuePolicy EventQueuePolicy = EBusEventQueuePolicy::Shared;
+
         static constexpr bool LocklessDispatch = false;
+
+        /*
+        * Publish the handlers as an immutable array, rebuilt on every connect/disconnect. Broadcast and EnumerateHandlers
+        * then take no lock and iterate the array, old arrays are freed by EBusEpoch once no dispatch can read them.
+        * Only for single address buses with multiple handlers and a MutexType, which still serializes connect/disconnect.
+        * Disconnect waits for the dispatches running on other threads, except when called from inside a dispatch.
+        */
+        static constexpr bool SnapshotDispatch = false;
+
+        /*
+        * Store the addresses of an EBusAddressPolicy::ById bus in a FlatAddressMap instead of an eastl::unordered_map.
+        * A bare lookup in the flat table is faster with a few dozen addresses and slower with thousands, but an Event
+        * is dominated by the dispatch itself and is not measurably faster at either size, so only enable it for a bus
+        * which measures a win.
+        */
+        static constexpr bool FlatAddressStorage = false;
         
         /*
         * \note Make sure you carefully consider the implication of switching this policy. If your code use EBusEnvironments and your storage policy is not
@@ -114,7 +146,9 @@ namespace Spark
 
         using HandlerNode = typename ImplTraits::HandlerNode;
 
-        using QueuePolicy = EBusQueuePolicy<Traits::EnableEventQueue, ThisType, EventQueueMutexType>;
+        using QueuePolicy = eastl::conditional_t<Traits::EnableEventQueue && Traits::EventQueuePolicy != EBusEventQueuePolicy::Shared,
+            EBusPerThreadQueuePolicy<ThisType, Traits::EventQueuePolicy == EBusEventQueuePolicy::PerThreadOrdered>,
+            EBusQueuePolicy<Traits::EnableEventQueue, ThisType, EventQueueMutexType>>;
 
         using CallstackEntry = CallstackEntry<Interface, Traits>;
 
@@ -143,6 +177,10 @@ namespace Spark
             "When you use EBusAddressPolicy::Single or EBusAddressPolicy::ById there is no need to define BusIdOrderCompare!");
         static_assert((BusTraits::AddressPolicy != EBusAddressPolicy::ByIdAndOrdered || !eastl::is_same<BusIdOrderCompare, NullBusIdCompare>::value),
             "When you use EBusAddressPolicy::ByIdAndOrdered you must define BusIdOrderCompare (ex. using BusIdOrderCompare = eastl::less<BusIdType>)");
+        static_assert(!BusTraits::SnapshotDispatch || (BusTraits::AddressPolicy == EBusAddressPolicy::Single && BusTraits::HandlerPolicy != EBusHandlerPolicy::Single),
+            "SnapshotDispatch is only supported by EBusAddressPolicy::Single buses with multiple handlers");
+        static_assert(!BusTraits::SnapshotDispatch || !eastl::is_same_v<MutexType, NullMutex>,
+            "SnapshotDispatch needs a MutexType to serialize connect and disconnect");
 
         class Context
         {
@@ -162,6 +200,7 @@ namespace Spark
             BusesContainer          m_buses;         ///< The actual bus container, which is a static map for each bus type.
             ContextMutexType        m_contextMutex;  ///< Mutex to control access when modifying the context
             QueuePolicy             m_queue;
+            EBusHandlerSnapshot<Interface, BusTraits::SnapshotDispatch> m_snapshot;  ///< Handlers read by lock free dispatch
 
             Context() = default;
             //Context(EBusEnvironment* environment);
@@ -316,6 +355,10 @@ namespace Spark
 
             // Do the actual connection
             context.m_buses.Connect(handler, id);
+            if constexpr (Traits::SnapshotDispatch)
+            {
+                context.m_snapshot.Publish(context.m_buses.m_handlers);
+            }
 
             BusPtr ptr;
             if constexpr (EBus::HasId)
@@ -330,8 +373,20 @@ namespace Spark
             if (Context* context = GetContext())
             {
                 // scoped lock guard in case of exception / other odd situation
-                ConnectLockGuard lock(context->m_contextMutex);
-                DisconnectInternal(*context, handler);
+                {
+                    ConnectLockGuard lock(context->m_contextMutex);
+                    DisconnectInternal(*context, handler);
+                }
+                SynchronizeDispatch();
+            }
+        }
+
+        /// @brief With SnapshotDispatch, wait for the dispatches on other threads which may still call a disconnected handler
+        inline static void SynchronizeDispatch()
+        {
+            if constexpr (Traits::SnapshotDispatch)
+            {
+                EBusEpoch::Synchronize();
             }
         }
 
@@ -356,6 +411,10 @@ namespace Spark
 
             // Do the actual disconnection
             context.m_buses.Disconnect(handler);
+            if constexpr (Traits::SnapshotDispatch)
+            {
+                context.m_snapshot.Publish(context.m_buses.m_handlers);
+            }
 
             if (callstack)
             {
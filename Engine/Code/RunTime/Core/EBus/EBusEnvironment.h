@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+
+#include <Log/SpdLogSystem.h>
+
+namespace Spark
+{
+    /// @brief A separate set of bus contexts.
+    ///
+    /// Buses opting into EBusEnvironmentStoragePolicy look up their context in the environment active on the
+    /// calling thread, and fall back to the global context when none is active. Other buses always use the global context.
+    /// Handlers connected while an environment is active only receive the events sent in the same environment,
+    /// so several worlds can dispatch the same buses on different threads without cross-talk or shared locks.
+    ///
+    /// A handler must be disconnected in the environment it was connected in, and all handlers must be
+    /// disconnected before the environment is destroyed.
+    class EBusEnvironment
+    {
+    public:
+        /// @brief Activate an environment on the calling thread for the lifetime of the scope.
+        ///  A null environment keeps the current one, so it can be used for optional bindings.
+        class Scope
+        {
+        public:
+            explicit Scope(EBusEnvironment* environment) : m_previous(Current()), m_active(environment != nullptr)
+            {
+                if (m_active)
+                {
+                    Current() = environment;
+                }
+            }
+
+            ~Scope()
+            {
+                if (m_active)
+                {
+                    Current() = m_previous;
+                }
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            EBusEnvironment* m_previous;
+            bool             m_active;
+        };
+
+        EBusEnvironment() = default;
+
+        ~EBusEnvironment()
+        {
+            assert(GetCurrent() != this && "Destroying an active EBusEnvironment");
+            for (Slot& slot : m_slots)
+            {
+                if (void* context = slot.m_context.load(std::memory_order_acquire))
+                {
+                    slot.m_deleter.load(std::memory_order_relaxed)(context);
+                }
+            }
+        }
+
+        EBusEnvironment(const EBusEnvironment&) = delete;
+        EBusEnvironment& operator=(const EBusEnvironment&) = delete;
+
+        /// @brief The environment active on the calling thread, nullptr for the global one
+        static EBusEnvironment* GetCurrent()
+        {
+            return Current();
+        }
+
+        /// @brief Thread safe, the context is created on first use
+        /// @return nullptr when the bus has no slot in environments, the caller falls back to the global context
+        template<typename Context>
+        Context* GetOrCreateContext()
+        {
+            const size_t index = GetBusIndex<Context>();
+            if (index >= MaxBusCount)
+            {
+                return nullptr;
+            }
+
+            Slot& slot = m_slots[index];
+            if (void* context = slot.m_context.load(std::memory_order_acquire))
+            {
+                return static_cast<Context*>(context);
+            }
+
+            // 多个线程同时创建时只保留一个
+            Context* created = new Context();
+            slot.m_deleter.store([](void* context) { delete static_cast<Context*>(context); }, std::memory_order_relaxed);
+            void* expected = nullptr;
+            if (!slot.m_context.compare_exchange_strong(expected, created, std::memory_order_acq_rel))
+            {
+                delete created;
+                return static_cast<Context*>(expected);
+            }
+            return created;
+        }
+
+    private:
+        static constexpr size_t MaxBusCount = 256;
+
+        struct Slot
+        {
+            std::atomic<void*>           m_context {nullptr};
+            std::atomic<void (*)(void*)> m_deleter {nullptr};
+        };
+
+        static EBusEnvironment*& Current()
+        {
+            static thread_local EBusEnvironment* t_current = nullptr;
+            return t_current;
+        }
+
+        /// @brief Dense index of a bus context type, assigned on first use
+        template<typename Context>
+        static size_t GetBusIndex()
+        {
+            static const size_t s_index = []()
+            {
+                const size_t index = NextBusIndex();
+                if (index >= MaxBusCount)
+                {
+                    // 超出的总线不再区分环境，只在第一次使用时报告
+                    LOG_ERROR("[EBusEnvironment] More than {} bus types use environments, bus type {} falls back to the global context",
+                        MaxBusCount, index);
+                }
+                return index;
+            }();
+            return s_index;
+        }
+
+        static size_t NextBusIndex()
+        {
+            static std::atomic<size_t> s_next {0};
+            return s_next.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::array<Slot, MaxBusCount> m_slots {};
+    };
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 #include <Log/SpdLogSystem.h>
 
@@ -140,7 +143,7 @@ namespace Spark
     template <class C>
     struct EBusCallstackStorage<C, true>
     {
-        EBusCallstackStorage() = default;
+        EBusCallstackStorage() : m_id(NextId()) {}
         ~EBusCallstackStorage() = default;
         EBusCallstackStorage(const EBusCallstackStorage&) = delete;
         EBusCallstackStorage(EBusCallstackStorage&&) = delete;
@@ -168,6 +171,20 @@ namespace Spark
 
     private:
         C*& GetEntry() const;
+
+        static uint64_t NextId()
+        {
+            static std::atomic<uint64_t> s_nextId {1};
+            return s_nextId.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        C*& FindEntry() const;
+
+        // 同一总线在不同EBusEnvironment中有多个context，各线程的调用栈保存在所属context中，随context一起释放
+        // 线程局部只缓存最近使用的context，使用id而不是地址，新context复用旧地址时不会取到已失效的调用栈
+        const uint64_t m_id;
+        mutable std::mutex m_mutex;
+        mutable std::unordered_map<std::thread::id, C*> m_entries;    ///< 节点式容器，插入后已有元素的引用保持有效
     };
 
     // This functino needs to be defined outside of the class definition such that it can get explicitly instantiated correctly. This is
@@ -175,7 +192,24 @@ namespace Spark
     template <class C>
     C*& EBusCallstackStorage<C, true>::GetEntry() const
     {
-        static thread_local C* s_entry = nullptr;
-        return s_entry;
+        static thread_local uint64_t s_lastId = 0;
+        static thread_local C** s_lastEntry = nullptr;
+        if (s_lastId == m_id)
+        {
+            return *s_lastEntry;
+        }
+
+        C*& entry = FindEntry();
+        s_lastId = m_id;
+        s_lastEntry = &entry;
+        return entry;
+    }
+
+    // 只在当前线程切换到另一个context时调用
+    template <class C>
+    C*& EBusCallstackStorage<C, true>::FindEntry() const
+    {
+        std::scoped_lock lock(m_mutex);
+        return m_entries[std::this_thread::get_id()];
     }
 }
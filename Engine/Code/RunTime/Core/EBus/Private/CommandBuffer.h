@@ -0,0 +1,222 @@
+#pragma once
+
+#include <new>
+#include <tuple>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <utility>
+
+#include <EASTL/vector.h>
+#include <EASTL/algorithm.h>
+#include <EASTL/functional.h>
+#include <EASTL/type_traits.h>
+
+namespace Spark
+{
+    /// @brief Header of a queued call, followed in memory by the function and its arguments constructed in place
+    struct alignas(std::max_align_t) EBusCommand
+    {
+        using InvokeFunc = void (*)(void*);
+        using DestroyFunc = void (*)(void*);
+
+        InvokeFunc  m_invoke;
+        DestroyFunc m_destroy;
+        uint32_t    m_size;         ///< Size of the command with its payload, offset of the next command
+        uint64_t    m_sequence;     ///< Order of the command among all the producers, 0 if not sequenced
+
+        template <typename Function, typename... InputArgs>
+        using Payload = std::tuple<eastl::decay_t<Function>, eastl::decay_t<InputArgs>...>;
+
+        template <typename Function, typename... InputArgs>
+        static constexpr size_t SizeOf()
+        {
+            using PayloadType = Payload<Function, InputArgs...>;
+            static_assert(alignof(PayloadType) <= alignof(std::max_align_t), "Over-aligned arguments can not be queued");
+            return sizeof(EBusCommand) + Align(sizeof(PayloadType));
+        }
+
+        /// @brief Construct a call of func(args...) at memory, which must hold SizeOf bytes.
+        ///  The arguments are called with the value category they were pushed with.
+        template <typename Function, typename... InputArgs>
+        static EBusCommand* Construct(void* memory, uint64_t sequence, Function&& func, InputArgs&&... args)
+        {
+            using PayloadType = Payload<Function, InputArgs...>;
+            constexpr size_t size = SizeOf<Function, InputArgs...>();
+            static_assert(size <= UINT32_MAX, "Queued call is too large");
+
+            EBusCommand* command = new (memory) EBusCommand{&InvokePayload<PayloadType, InputArgs...>, &DestroyPayload<PayloadType>,
+                static_cast<uint32_t>(size), sequence};
+            new (command->GetPayload()) PayloadType(eastl::forward<Function>(func), eastl::forward<InputArgs>(args)...);
+            return command;
+        }
+
+        void* GetPayload()
+        {
+            return this + 1;
+        }
+
+        void Invoke()
+        {
+            m_invoke(GetPayload());
+        }
+
+        void Destroy()
+        {
+            m_destroy(GetPayload());
+        }
+
+        static constexpr size_t Align(size_t size)
+        {
+            return (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+        }
+
+    private:
+        template <typename PayloadType, typename... InputArgs>
+        static void InvokePayload(void* payload)
+        {
+            InvokeImpl<InputArgs...>(*static_cast<PayloadType*>(payload), eastl::make_index_sequence<sizeof...(InputArgs)>());
+        }
+
+        template <typename... InputArgs, typename PayloadType, size_t... Index>
+        static void InvokeImpl(PayloadType& call, eastl::index_sequence<Index...>)
+        {
+            // 与QueueFunction的参数保持相同的值类别
+            eastl::invoke(std::get<0>(call), static_cast<InputArgs&&>(std::get<Index + 1>(call))...);
+        }
+
+        template <typename PayloadType>
+        static void DestroyPayload(void* payload)
+        {
+            static_cast<PayloadType*>(payload)->~PayloadType();
+        }
+    };
+
+    /// @brief Bump allocated list of type erased calls, used by the EBus event queue.
+    ///
+    /// Every record is an EBusCommand. Records are executed in push order and destroyed right after their call.
+    /// The pages are kept by Reset, so a buffer that has been warmed up queues calls without allocating.
+    template <typename Allocator>
+    class EBusCommandBuffer
+    {
+    public:
+        /// Size of a page, a record larger than this gets a page of its own
+        static constexpr size_t PageSize = 16 * 1024;
+
+        explicit EBusCommandBuffer(const Allocator& allocator = Allocator())
+            : m_allocator(allocator)
+        {
+        }
+
+        ~EBusCommandBuffer()
+        {
+            Reset();
+            for (Page& page : m_pages)
+            {
+                m_allocator.deallocate(page.m_data, page.m_capacity);
+            }
+        }
+
+        EBusCommandBuffer(const EBusCommandBuffer&) = delete;
+        EBusCommandBuffer& operator=(const EBusCommandBuffer&) = delete;
+
+        /// @brief Store a call of func(args...), the arguments are called with the value category they were pushed with
+        template <typename Function, typename... InputArgs>
+        void Push(Function&& func, InputArgs&&... args)
+        {
+            void* memory = Allocate(EBusCommand::SizeOf<Function, InputArgs...>());
+            EBusCommand::Construct(memory, 0, eastl::forward<Function>(func), eastl::forward<InputArgs>(args)...);
+        }
+
+        /// @brief Call and destroy all the records in order, then reset the buffer
+        void Execute()
+        {
+            ForEachCommand([](EBusCommand* command)
+            {
+                command->Invoke();
+                command->Destroy();
+            });
+            Rewind();
+        }
+
+        /// @brief Destroy all the records without calling them
+        void Reset()
+        {
+            ForEachCommand([](EBusCommand* command)
+            {
+                command->Destroy();
+            });
+            Rewind();
+        }
+
+        size_t Count() const
+        {
+            return m_count;
+        }
+
+        bool Empty() const
+        {
+            return m_count == 0;
+        }
+
+    private:
+        struct Page
+        {
+            char*  m_data {nullptr};
+            size_t m_capacity {0};
+            size_t m_used {0};
+        };
+
+        void* Allocate(size_t size)
+        {
+            while (m_current < m_pages.size() && m_pages[m_current].m_used + size > m_pages[m_current].m_capacity)
+            {
+                ++m_current;
+            }
+            if (m_current == m_pages.size())
+            {
+                Page& page = m_pages.push_back();
+                page.m_capacity = eastl::max(PageSize, size);
+                page.m_data = static_cast<char*>(m_allocator.allocate(page.m_capacity, alignof(std::max_align_t), 0));
+            }
+
+            Page& page = m_pages[m_current];
+            void* memory = page.m_data + page.m_used;
+            page.m_used += size;
+            ++m_count;
+            return memory;
+        }
+
+        template <typename Callback>
+        void ForEachCommand(Callback&& callback)
+        {
+            const size_t pageCount = eastl::min(m_current + 1, m_pages.size());
+            for (size_t index = 0; index < pageCount; ++index)
+            {
+                Page& page = m_pages[index];
+                size_t offset = 0;
+                while (offset < page.m_used)
+                {
+                    EBusCommand* command = reinterpret_cast<EBusCommand*>(page.m_data + offset);
+                    offset += command->m_size;
+                    callback(command);
+                }
+            }
+        }
+
+        void Rewind()
+        {
+            for (Page& page : m_pages)
+            {
+                page.m_used = 0;
+            }
+            m_current = 0;
+            m_count = 0;
+        }
+
+        Allocator           m_allocator;
+        eastl::vector<Page> m_pages;
+        size_t              m_current {0};
+        size_t              m_count {0};
+    };
+}
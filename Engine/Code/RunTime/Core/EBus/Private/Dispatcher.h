@@ -1,10 +1,13 @@
 #pragma once
 
 #include <EASTL/functional.h>
+#include <EASTL/fixed_vector.h>
+#include <EASTL/algorithm.h>
 
 #include "Polices.h"
 #include "Container.h"
 #include "CallstackEntry.h"
+#include "HandlerSnapshot.h"
 
 
 namespace Spark
@@ -52,6 +55,44 @@ namespace Spark
         return MidDispatchDisconnectFixer<Bus, PreHandler, PostHandler>(context, busId, eastl::forward<PreHandler>(remove), eastl::forward<PostHandler>(post));
     }
 
+    // Lock free dispatch over the handler snapshot of a SnapshotDispatch bus, stops when callback returns false
+    template <typename Bus, typename Callback>
+    void DispatchSnapshot(typename Bus::Context* context, Callback&& callback)
+    {
+        using InterfaceType = typename Bus::InterfaceType;
+
+        EBusEpoch::ReadScope readScope;
+        const auto* snapshot = context->m_snapshot.Acquire();
+        if (!snapshot)
+        {
+            return;
+        }
+
+        // 快照不可修改，记录本线程在分发中断开的处理器并跳过
+        eastl::fixed_vector<InterfaceType*, 4, true> removed;
+        auto fixer = MakeDisconnectFixer<Bus>(context, nullptr,
+            [&removed](InterfaceType* handler)
+            {
+                removed.push_back(handler);
+            },
+            []()
+            {
+            }
+        );
+
+        for (InterfaceType* handler : *snapshot)
+        {
+            if (!removed.empty() && eastl::find(removed.begin(), removed.end(), handler) != removed.end())
+            {
+                continue;
+            }
+            if (!callback(handler))
+            {
+                return;
+            }
+        }
+    }
+
 
     // Default impl, used when there are multiple addresses and multiple handlers
     template <typename EBus, typename Traits, EBusAddressPolicy addressPolicy = Traits::AddressPolicy, EBusHandlerPolicy handlerPolicy = Traits::HandlerPolicy>
@@ -519,7 +560,18 @@ namespace Spark
         template <typename Function, typename... Args>
         static void Broadcast(Function&& func, Args&&... args)
         {
-            if (auto* context = Bus::GetContext())
+            if constexpr (Traits::SnapshotDispatch)
+            {
+                if (auto* context = Bus::GetContext())
+                {
+                    DispatchSnapshot<Bus>(context, [&](InterfaceType* handler)
+                    {
+                        Traits::EventProcessingPolicy::Call(func, handler, args...);
+                        return true;
+                    });
+                }
+            }
+            else if (auto* context = Bus::GetContext())
             {
                 typename Bus::Context::DispatchLockGuard lock(context->m_contextMutex);
 
@@ -554,7 +606,18 @@ namespace Spark
         template <typename Results, typename Function, typename... Args>
         static void BroadcastResult(Results& results, Function&& func, Args&&... args)
         {
-            if (auto* context = Bus::GetContext())
+            if constexpr (Traits::SnapshotDispatch)
+            {
+                if (auto* context = Bus::GetContext())
+                {
+                    DispatchSnapshot<Bus>(context, [&](InterfaceType* handler)
+                    {
+                        Traits::EventProcessingPolicy::CallResult(results, func, handler, args...);
+                        return true;
+                    });
+                }
+            }
+            else if (auto* context = Bus::GetContext())
             {
                 typename Bus::Context::DispatchLockGuard lock(context->m_contextMutex);
 
@@ -917,7 +980,19 @@ namespace Spark
         template <typename Callback>
         static void EnumerateHandlers(Callback&& callback)
         {
-            if (auto* context = Bus::GetContext())
+            if constexpr (Traits::SnapshotDispatch)
+            {
+                if (auto* context = Bus::GetContext())
+                {
+                    DispatchSnapshot<Bus>(context, [&](InterfaceType* handler)
+                    {
+                        bool result = false;
+                        Traits::EventProcessingPolicy::CallResult(result, callback, handler);
+                        return result;
+                    });
+                }
+            }
+            else if (auto* context = Bus::GetContext())
             {
                 typename Bus::Context::DispatchLockGuard lock(context->m_contextMutex);
 
@@ -91,6 +91,8 @@ namespace Spark
 
         static constexpr bool HasId = Traits::AddressPolicy != EBusAddressPolicy::Single;
 
+        static constexpr bool SnapshotDispatch = Traits::SnapshotDispatch;
+
         template <typename DispatchMutex>
         using DispatchLockGuard = typename Traits::template DispatchLockGuard<DispatchMutex, Traits::LocklessDispatch>;
 
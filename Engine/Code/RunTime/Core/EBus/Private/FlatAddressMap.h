@@ -0,0 +1,421 @@
+#pragma once
+
+#include <new>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+#include <EASTL/vector.h>
+#include <EASTL/utility.h>
+#include <EASTL/algorithm.h>
+#include <EASTL/functional.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Spark
+{
+    /// @brief Open addressing hash map from bus id to HandlerHolder, the address storage of EBusAddressPolicy::ById
+    ///  buses which enable EBusTraits::FlatAddressStorage.
+    ///
+    /// The table is an array of cache line groups, each holding the one byte tags, the keys and the value pointers
+    /// of a few slots. A lookup compares the tags of a group at once and then the keys stored next to them, so the
+    /// only load outside the group is the value found.
+    /// The values live in pooled nodes which are never moved, so the BusPtr references to a HandlerHolder stay valid
+    /// while the table grows. Erase leaves a tombstone, an iterator on another address stays valid; an insert which
+    /// grows the table may reorder the addresses not visited yet by a running iteration.
+    template <typename Key, typename Value, typename Allocator, typename Hash = eastl::hash<Key>>
+    class FlatAddressMap
+    {
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+
+        /// Element seen through an iterator, the key is in the table and the value in its node
+        struct value_type
+        {
+            const Key& first;
+            Value&     second;
+        };
+
+        class iterator
+        {
+        public:
+            struct pointer
+            {
+                value_type m_value;
+
+                value_type* operator->()
+                {
+                    return &m_value;
+                }
+            };
+
+            iterator() = default;
+            iterator(const FlatAddressMap* map, size_t index) : m_map(map), m_index(index) {}
+
+            value_type operator*() const
+            {
+                return m_map->EntryAt(m_index);
+            }
+
+            pointer operator->() const
+            {
+                return {m_map->EntryAt(m_index)};
+            }
+
+            iterator& operator++()
+            {
+                m_index = m_map->NextFull(m_index + 1);
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator it(*this);
+                ++(*this);
+                return it;
+            }
+
+            bool operator==(const iterator& other) const
+            {
+                return m_index == other.m_index;
+            }
+
+            bool operator!=(const iterator& other) const
+            {
+                return m_index != other.m_index;
+            }
+
+        private:
+            friend class FlatAddressMap;
+
+            const FlatAddressMap* m_map {nullptr};
+            size_t                m_index {End};     ///< Group * GroupStride + slot in the group
+        };
+
+        using const_iterator = iterator;
+
+        explicit FlatAddressMap(const Allocator& allocator = Allocator())
+            : m_allocator(allocator)
+            , m_nodePages(allocator)
+        {
+        }
+
+        ~FlatAddressMap()
+        {
+            for (size_t index = 0; index < m_groupCount; ++index)
+            {
+                Group& group = m_groups[index];
+                for (size_t slot = 0; slot < GroupSlots; ++slot)
+                {
+                    if (IsFull(group.m_tags[slot]))
+                    {
+                        group.m_keys[slot].~Key();
+                        group.m_values[slot]->~Value();
+                    }
+                }
+            }
+            FreeGroups(m_groupMemory, m_groupCount);
+            for (void* page : m_nodePages)
+            {
+                m_allocator.deallocate(page, sizeof(Node) * NodesPerPage);
+            }
+        }
+
+        FlatAddressMap(const FlatAddressMap&) = delete;
+        FlatAddressMap& operator=(const FlatAddressMap&) = delete;
+
+        iterator begin() const
+        {
+            return iterator(this, NextFull(0));
+        }
+
+        iterator end() const
+        {
+            return iterator(this, End);
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        iterator find(const Key& key) const
+        {
+            if (m_size == 0)
+            {
+                return end();
+            }
+
+            const size_t hash = HashOf(key);
+            const uint8_t tag = TagOf(hash);
+            const size_t groupMask = m_groupCount - 1;
+            for (size_t index = hash & groupMask;; index = (index + 1) & groupMask)
+            {
+                const Group& group = m_groups[index];
+                const uint64_t tags = group.LoadTags();
+                for (uint64_t bits = MatchByte(tags, tag); bits; bits &= bits - 1)
+                {
+                    const size_t slot = FirstByte(bits);
+                    if (group.m_keys[slot] == key)
+                    {
+                        return iterator(this, index * GroupStride + slot);
+                    }
+                }
+                if (MatchByte(tags, Empty))
+                {
+                    return end();
+                }
+            }
+        }
+
+        /// @brief Insert a key which is not in the map yet, the value is moved into a pooled node
+        iterator emplace(eastl::pair<Key, Value>&& entry)
+        {
+            assert(find(entry.first) == end() && "[EBus] Failed to insert");
+            if ((m_size + m_tombstones + 1) * 8 > m_groupCount * GroupSlots * 7)
+            {
+                // 墓碑过多时按原大小重建，否则扩容
+                Rehash(m_size * 2 < m_groupCount * GroupSlots ? m_groupCount : eastl::max<size_t>(m_groupCount * 2, 1));
+            }
+
+            Value* value = new (AllocateNode()) Value(eastl::move(entry.second));
+            const size_t hash = HashOf(entry.first);
+            const size_t index = FindInsertSlot(hash);
+            Group& group = m_groups[index / GroupStride];
+            const size_t slot = index % GroupStride;
+            if (group.m_tags[slot] == Deleted)
+            {
+                --m_tombstones;
+            }
+            group.m_tags[slot] = TagOf(hash);
+            new (&group.m_keys[slot]) Key(eastl::move(entry.first));
+            group.m_values[slot] = value;
+            ++m_size;
+            return iterator(this, index);
+        }
+
+        void erase(const Key& key)
+        {
+            iterator it = find(key);
+            if (it == end())
+            {
+                return;
+            }
+
+            Group& group = m_groups[it.m_index / GroupStride];
+            const size_t slot = it.m_index % GroupStride;
+            Value* value = group.m_values[slot];
+            group.m_tags[slot] = Deleted;
+            group.m_keys[slot].~Key();
+            group.m_values[slot] = nullptr;
+            --m_size;
+            ++m_tombstones;
+
+            value->~Value();
+            FreeNode(value);
+        }
+
+    private:
+        static constexpr size_t End = SIZE_MAX;
+        static constexpr size_t CacheLine = 64;
+        static constexpr size_t GroupStride = 8;
+        /// Slots of a group, as many as fit in a cache line next to the 8 tag bytes, between 1 and 7
+        static constexpr size_t GroupSlots = eastl::max<size_t>(1, eastl::min<size_t>(7,
+            (CacheLine - GroupStride) / (sizeof(Key) + sizeof(Value*))));
+        static constexpr size_t NodesPerPage = 64;
+
+        static constexpr uint8_t Empty = 0;
+        static constexpr uint8_t Deleted = 1;
+
+        static constexpr uint64_t LowBits = 0x0101010101010101ull;
+        ///< High bit of the tags of the used slots, the other bytes stay Empty
+        static constexpr uint64_t SlotBits = 0x8080808080808080ull >> (8 * (GroupStride - GroupSlots));
+
+        // 标签、键和值指针放在同一个缓存行，键按槽位原地构造
+        struct alignas(CacheLine) Group
+        {
+            uint8_t m_tags[GroupStride] {};
+            union
+            {
+                Key m_keys[GroupSlots];
+            };
+            Value* m_values[GroupSlots] {};
+
+            Group() {}
+            ~Group() {}
+
+            uint64_t LoadTags() const
+            {
+                uint64_t tags;
+                memcpy(&tags, m_tags, sizeof(tags));
+                return tags;
+            }
+        };
+
+        union Node
+        {
+            Node*                        m_next;
+            alignas(Value) unsigned char m_storage[sizeof(Value)];
+        };
+
+        static bool IsFull(uint8_t tag)
+        {
+            return (tag & 0x80) != 0;
+        }
+
+        // 整数id的eastl::hash是恒等映射，乘法混合后高位作为标签，折叠后的低位选择分组
+        static size_t HashOf(const Key& key)
+        {
+            const uint64_t hash = static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+            return static_cast<size_t>(hash ^ (hash >> 32));
+        }
+
+        static uint8_t TagOf(size_t hash)
+        {
+            return static_cast<uint8_t>(0x80 | (hash >> (sizeof(size_t) * 8 - 7)));
+        }
+
+        /// @brief High bit of each slot tag equal to value. A byte above a match may be reported falsely,
+        ///  the candidates are checked by comparing the keys.
+        static uint64_t MatchByte(uint64_t tags, uint8_t value)
+        {
+            const uint64_t x = tags ^ (LowBits * value);
+            return (x - LowBits) & ~x & SlotBits;
+        }
+
+        static size_t FirstByte(uint64_t bits)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, bits);
+            return index / 8;
+#else
+            return static_cast<size_t>(__builtin_ctzll(bits)) / 8;
+#endif
+        }
+
+        value_type EntryAt(size_t index) const
+        {
+            const Group& group = m_groups[index / GroupStride];
+            return {group.m_keys[index % GroupStride], *group.m_values[index % GroupStride]};
+        }
+
+        size_t NextFull(size_t index) const
+        {
+            for (; index < m_groupCount * GroupStride; ++index)
+            {
+                const size_t slot = index % GroupStride;
+                if (slot < GroupSlots && IsFull(m_groups[index / GroupStride].m_tags[slot]))
+                {
+                    return index;
+                }
+            }
+            return End;
+        }
+
+        size_t FindInsertSlot(size_t hash) const
+        {
+            const size_t groupMask = m_groupCount - 1;
+            for (size_t index = hash & groupMask;; index = (index + 1) & groupMask)
+            {
+                // 空槽和墓碑的标签最高位为0
+                if (const uint64_t bits = ~m_groups[index].LoadTags() & SlotBits)
+                {
+                    return index * GroupStride + FirstByte(bits);
+                }
+            }
+        }
+
+        // 只移动键和值指针，值节点的地址不变
+        void Rehash(size_t groupCount)
+        {
+            void* memory = m_groupMemory;
+            Group* groups = m_groups;
+            const size_t count = m_groupCount;
+            m_groupMemory = AllocateGroups(groupCount, m_groups);
+            m_groupCount = groupCount;
+            m_tombstones = 0;
+
+            for (size_t index = 0; index < count; ++index)
+            {
+                Group& group = groups[index];
+                for (size_t slot = 0; slot < GroupSlots; ++slot)
+                {
+                    if (IsFull(group.m_tags[slot]))
+                    {
+                        const size_t target = FindInsertSlot(HashOf(group.m_keys[slot]));
+                        Group& targetGroup = m_groups[target / GroupStride];
+                        targetGroup.m_tags[target % GroupStride] = group.m_tags[slot];
+                        new (&targetGroup.m_keys[target % GroupStride]) Key(eastl::move(group.m_keys[slot]));
+                        targetGroup.m_values[target % GroupStride] = group.m_values[slot];
+                        group.m_keys[slot].~Key();
+                    }
+                }
+            }
+            FreeGroups(memory, count);
+        }
+
+        // 引擎的分配器不保证对齐，多分配一个分组手动对齐到缓存行
+        void* AllocateGroups(size_t count, Group*& groups)
+        {
+            void* memory = m_allocator.allocate(sizeof(Group) * (count + 1), alignof(Group), 0);
+            const uintptr_t address = (reinterpret_cast<uintptr_t>(memory) + alignof(Group) - 1) & ~(uintptr_t(alignof(Group)) - 1);
+            groups = reinterpret_cast<Group*>(address);
+            for (size_t index = 0; index < count; ++index)
+            {
+                new (groups + index) Group();
+            }
+            return memory;
+        }
+
+        void FreeGroups(void* memory, size_t count)
+        {
+            if (memory)
+            {
+                m_allocator.deallocate(memory, sizeof(Group) * (count + 1));
+            }
+        }
+
+        void* AllocateNode()
+        {
+            if (!m_freeNodes)
+            {
+                Node* page = static_cast<Node*>(m_allocator.allocate(sizeof(Node) * NodesPerPage, alignof(Node), 0));
+                m_nodePages.push_back(page);
+                for (size_t i = NodesPerPage; i > 0; --i)
+                {
+                    page[i - 1].m_next = m_freeNodes;
+                    m_freeNodes = &page[i - 1];
+                }
+            }
+
+            Node* node = m_freeNodes;
+            m_freeNodes = node->m_next;
+            return node->m_storage;
+        }
+
+        void FreeNode(Value* value)
+        {
+            Node* node = reinterpret_cast<Node*>(value);
+            node->m_next = m_freeNodes;
+            m_freeNodes = node;
+        }
+
+        Allocator                       m_allocator;
+        void*                           m_groupMemory {nullptr};
+        Group*                          m_groups {nullptr};
+        size_t                          m_groupCount {0};   ///< Power of two
+        size_t                          m_size {0};
+        size_t                          m_tombstones {0};
+        eastl::vector<void*, Allocator> m_nodePages;        ///< Pooled value nodes, never moved
+        Node*                           m_freeNodes {nullptr};
+    };
+}
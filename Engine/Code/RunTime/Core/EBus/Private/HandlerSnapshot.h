@@ -0,0 +1,343 @@
+#pragma once
+
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <cassert>
+
+#include <EASTL/vector.h>
+
+namespace Spark
+{
+    /// @brief Epoch based reclamation shared by all the buses using SnapshotDispatch.
+    ///
+    /// A dispatch reads the handler snapshot inside a ReadScope, which publishes the global epoch seen on entry.
+    /// A retired snapshot is freed once every thread in a read scope entered after it was retired, so a dispatch
+    /// never waits for connect/disconnect and never sees freed memory.
+    class EBusEpoch
+    {
+    public:
+        class ReadScope
+        {
+        public:
+            ReadScope()
+            {
+                Enter();
+            }
+
+            ~ReadScope()
+            {
+                Exit();
+            }
+
+            ReadScope(const ReadScope&) = delete;
+            ReadScope& operator=(const ReadScope&) = delete;
+        };
+
+        static void Enter()
+        {
+            Reader& reader = LocalReader();
+            if (reader.m_nesting++ == 0)
+            {
+                reader.m_epoch.store(GetDomain().m_epoch.load());
+            }
+        }
+
+        static void Exit()
+        {
+            Reader& reader = LocalReader();
+            assert(reader.m_nesting > 0 && "EBusEpoch::Exit without Enter");
+            if (--reader.m_nesting == 0)
+            {
+                reader.m_epoch.store(0);
+                if (GetDomain().m_retiredCount.load(std::memory_order_relaxed) > 0)
+                {
+                    Collect(false);
+                }
+            }
+        }
+
+        static bool IsReading()
+        {
+            return LocalReader().m_nesting > 0;
+        }
+
+        /// @brief Free ptr once no reader can still hold it, ptr must already be unpublished
+        static void Retire(void* ptr, void (*deleter)(void*))
+        {
+            Domain& domain = GetDomain();
+            {
+                std::lock_guard lock(domain.m_retiredMutex);
+                domain.m_retired.push_back({ptr, deleter, domain.m_epoch.fetch_add(1)});
+                domain.m_retiredCount.store(domain.m_retired.size(), std::memory_order_relaxed);
+            }
+            Collect(true);
+        }
+
+        /// @brief Wait until the read scopes opened on other threads before the call are closed.
+        ///  Returns immediately inside a read scope, waiting there could deadlock with another waiting reader.
+        static void Synchronize()
+        {
+            Reader& self = LocalReader();
+            if (self.m_nesting > 0)
+            {
+                return;
+            }
+
+            Domain& domain = GetDomain();
+            const uint64_t epoch = domain.m_epoch.fetch_add(1);
+            for (Reader* reader = domain.m_readers.load(); reader; reader = reader->m_next)
+            {
+                while (true)
+                {
+                    const uint64_t readerEpoch = reader->m_epoch.load();
+                    if (readerEpoch == 0 || readerEpoch > epoch)
+                    {
+                        break;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+            Collect(true);
+        }
+
+    private:
+        struct Reader
+        {
+            std::atomic<uint64_t> m_epoch {0};   ///< Epoch seen when entering the outermost read scope, 0 when outside
+            std::atomic<bool>     m_used {false};
+            uint32_t              m_nesting {0};
+            Reader*               m_next {nullptr};
+        };
+
+        struct Retired
+        {
+            void*    m_ptr;
+            void     (*m_deleter)(void*);
+            uint64_t m_epoch;
+        };
+
+        struct Domain
+        {
+            std::atomic<uint64_t>  m_epoch {1};
+            std::atomic<Reader*>   m_readers {nullptr};
+            std::mutex             m_retiredMutex;
+            eastl::vector<Retired> m_retired;
+            std::atomic<size_t>    m_retiredCount {0};
+
+            ~Domain()
+            {
+                for (const Retired& retired : m_retired)
+                {
+                    retired.m_deleter(retired.m_ptr);
+                }
+            }
+        };
+
+        // 线程退出时归还Reader，Reader本身不释放，遍历时无需加锁
+        struct ReaderHandle
+        {
+            Reader* m_reader;
+
+            ReaderHandle() : m_reader(Acquire())
+            {
+            }
+
+            ~ReaderHandle()
+            {
+                m_reader->m_epoch.store(0);
+                m_reader->m_used.store(false, std::memory_order_release);
+            }
+        };
+
+        static Domain& GetDomain()
+        {
+            static Domain s_domain;
+            return s_domain;
+        }
+
+        static Reader& LocalReader()
+        {
+            static thread_local ReaderHandle t_handle;
+            return *t_handle.m_reader;
+        }
+
+        static Reader* Acquire()
+        {
+            Domain& domain = GetDomain();
+            for (Reader* reader = domain.m_readers.load(); reader; reader = reader->m_next)
+            {
+                bool used = false;
+                if (!reader->m_used.load(std::memory_order_relaxed) && reader->m_used.compare_exchange_strong(used, true))
+                {
+                    return reader;
+                }
+            }
+
+            Reader* reader = new Reader();
+            reader->m_used.store(true, std::memory_order_relaxed);
+            Reader* head = domain.m_readers.load();
+            do
+            {
+                reader->m_next = head;
+            } while (!domain.m_readers.compare_exchange_weak(head, reader));
+            return reader;
+        }
+
+        /// @brief Free the retired pointers older than every active reader
+        static void Collect(bool wait)
+        {
+            Domain& domain = GetDomain();
+            std::unique_lock lock(domain.m_retiredMutex, std::defer_lock);
+            if (wait)
+            {
+                lock.lock();
+            }
+            else if (!lock.try_lock())
+            {
+                return;
+            }
+
+            uint64_t oldest = UINT64_MAX;
+            for (Reader* reader = domain.m_readers.load(); reader; reader = reader->m_next)
+            {
+                const uint64_t epoch = reader->m_epoch.load();
+                if (epoch != 0 && epoch < oldest)
+                {
+                    oldest = epoch;
+                }
+            }
+
+            eastl::vector<Retired> freed;
+            auto it = domain.m_retired.begin();
+            while (it != domain.m_retired.end())
+            {
+                if (it->m_epoch < oldest)
+                {
+                    freed.push_back(*it);
+                    it = domain.m_retired.erase_unsorted(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            domain.m_retiredCount.store(domain.m_retired.size(), std::memory_order_relaxed);
+            lock.unlock();
+
+            for (const Retired& retired : freed)
+            {
+                retired.m_deleter(retired.m_ptr);
+            }
+        }
+    };
+
+    /// @brief Immutable contiguous array of the handlers of a bus, published by EBusHandlerSnapshot
+    template <typename Interface>
+    class HandlerSnapshot
+    {
+    public:
+        Interface* const* begin() const
+        {
+            return Data();
+        }
+
+        Interface* const* end() const
+        {
+            return Data() + m_size;
+        }
+
+        Interface* const* Data() const
+        {
+            return reinterpret_cast<Interface* const*>(this + 1);
+        }
+
+        uint32_t Size() const
+        {
+            return m_size;
+        }
+
+        /// @brief The handlers are stored right after the header in one allocation
+        template <typename Handlers>
+        static HandlerSnapshot* Create(const Handlers& handlers)
+        {
+            uint32_t size = 0;
+            for (auto it = handlers.begin(); it != handlers.end(); ++it)
+            {
+                ++size;
+            }
+            if (size == 0)
+            {
+                return nullptr;
+            }
+
+            void* memory = ::operator new(sizeof(HandlerSnapshot) + size * sizeof(Interface*));
+            HandlerSnapshot* snapshot = new (memory) HandlerSnapshot();
+            snapshot->m_size = size;
+
+            Interface** data = reinterpret_cast<Interface**>(snapshot + 1);
+            for (auto it = handlers.begin(); it != handlers.end(); ++it)
+            {
+                *data++ = it->m_interface;
+            }
+            return snapshot;
+        }
+
+        static void Destroy(void* snapshot)
+        {
+            static_cast<HandlerSnapshot*>(snapshot)->~HandlerSnapshot();
+            ::operator delete(snapshot);
+        }
+
+    private:
+        HandlerSnapshot() = default;
+
+        alignas(alignof(Interface*)) uint32_t m_size {0};
+    };
+
+    /// @brief Handler snapshot of a bus context, empty unless the bus enables SnapshotDispatch
+    template <typename Interface, bool IsEnabled>
+    struct EBusHandlerSnapshot
+    {
+    };
+
+    template <typename Interface>
+    struct EBusHandlerSnapshot<Interface, true>
+    {
+        using SnapshotType = HandlerSnapshot<Interface>;
+
+        EBusHandlerSnapshot() = default;
+
+        ~EBusHandlerSnapshot()
+        {
+            if (SnapshotType* snapshot = m_current.load())
+            {
+                SnapshotType::Destroy(snapshot);
+            }
+        }
+
+        EBusHandlerSnapshot(const EBusHandlerSnapshot&) = delete;
+        EBusHandlerSnapshot& operator=(const EBusHandlerSnapshot&) = delete;
+
+        /// @brief Must be called inside an EBusEpoch::ReadScope, the snapshot is valid until the scope closes
+        const SnapshotType* Acquire() const
+        {
+            return m_current.load();
+        }
+
+        /// @brief Rebuild the snapshot from the handler storage, called with the context mutex locked
+        template <typename Handlers>
+        void Publish(const Handlers& handlers)
+        {
+            SnapshotType* previous = m_current.exchange(SnapshotType::Create(handlers));
+            if (previous)
+            {
+                EBusEpoch::Retire(previous, &SnapshotType::Destroy);
+            }
+        }
+
+        std::atomic<SnapshotType*> m_current {nullptr};
+    };
+}
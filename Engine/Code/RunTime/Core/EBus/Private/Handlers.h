@@ -22,7 +22,7 @@ namespace Spark
      */
     template <typename Interface, typename Traits, typename HandlerHolder, bool hasId = Traits::AddressPolicy != EBusAddressPolicy::Single>
     class HandlerNode
-        : public HandlerStorageNode<HandlerNode<Interface, Traits, HandlerHolder, true>, Traits::HandlerPolicy>
+        : public HandlerStorageNode<HandlerNode<Interface, Traits, HandlerHolder, true>, Traits::HandlerPolicy, typename Traits::BusHandlerOrderKey>
     {
     public:
         HandlerNode(Interface* inst)
@@ -84,7 +84,7 @@ namespace Spark
     // 如果 AddressPolicy == EBusAddressPolicy::Single，不需要HandlerHolder
     template <typename Interface, typename Traits, typename HandlerHolder>
     class HandlerNode<Interface, Traits, HandlerHolder, false>
-        : public HandlerStorageNode<HandlerNode<Interface, Traits, HandlerHolder, false>, Traits::HandlerPolicy>
+        : public HandlerStorageNode<HandlerNode<Interface, Traits, HandlerHolder, false>, Traits::HandlerPolicy, typename Traits::BusHandlerOrderKey>
     {
     public:
         HandlerNode(Interface* inst)
@@ -210,11 +210,15 @@ namespace Spark
         {
             if (typename BusType::Context* context = BusType::GetContext())
             {
-                typename BusType::Context::ConnectLockGuard contextLock(context->m_contextMutex);
-                if (BusIsConnected())
                 {
+                    typename BusType::Context::ConnectLockGuard contextLock(context->m_contextMutex);
+                    if (!BusIsConnected())
+                    {
+                        return;
+                    }
                     BusType::DisconnectInternal(*context, m_node);
                 }
+                BusType::SynchronizeDispatch();
             }
         }
 
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cassert>
+
+#include <EASTL/internal/red_black_tree.h>
+
+namespace Spark
+{
+    /// @brief Base of the handler nodes of EBusHandlerPolicy::MultipleAndOrdered buses
+    struct OrderedHandlerTreeNode
+        : public eastl::rbtree_node_base
+    {
+        OrderedHandlerTreeNode()
+        {
+            mpNodeRight = nullptr;
+            mpNodeLeft = nullptr;
+            mpNodeParent = nullptr;
+            mColor = eastl::kRBTreeColorRed;
+        }
+
+        // 节点的链接属于所在的树，复制处理器时不复制
+        OrderedHandlerTreeNode(const OrderedHandlerTreeNode&) : OrderedHandlerTreeNode() {}
+        OrderedHandlerTreeNode& operator=(const OrderedHandlerTreeNode&) { return *this; }
+    };
+
+    /// @brief Intrusive red-black tree of handler nodes, kept sorted by Compare.
+    ///
+    /// Insert and erase are O(log n) and never move or relink the other nodes' identity, so an iterator on a node
+    /// stays valid until that node is erased; iteration is in order, handlers comparing equal keep their connection
+    /// order. Node must derive from OrderedHandlerTreeNode, Compare is called as Compare{}(const Node&, const Node&).
+    template <typename Node, typename Compare>
+    class OrderedHandlerTree
+    {
+    public:
+        class iterator
+        {
+        public:
+            iterator() = default;
+            explicit iterator(eastl::rbtree_node_base* node) : m_node(node) {}
+
+            Node& operator*() const
+            {
+                return *static_cast<Node*>(m_node);
+            }
+
+            Node* operator->() const
+            {
+                return static_cast<Node*>(m_node);
+            }
+
+            iterator& operator++()
+            {
+                m_node = eastl::RBTreeIncrement(m_node);
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator it(*this);
+                m_node = eastl::RBTreeIncrement(m_node);
+                return it;
+            }
+
+            bool operator==(const iterator& other) const
+            {
+                return m_node == other.m_node;
+            }
+
+            bool operator!=(const iterator& other) const
+            {
+                return m_node != other.m_node;
+            }
+
+        private:
+            eastl::rbtree_node_base* m_node {nullptr};
+        };
+
+        using const_iterator = iterator;
+
+        OrderedHandlerTree()
+        {
+            Reset();
+        }
+
+        OrderedHandlerTree(OrderedHandlerTree&& other)
+        {
+            Reset();
+            if (other.m_anchor.mpNodeParent)
+            {
+                m_anchor = other.m_anchor;
+                m_anchor.mpNodeParent->mpNodeParent = &m_anchor;
+                m_size = other.m_size;
+                other.Reset();
+            }
+        }
+
+        OrderedHandlerTree(const OrderedHandlerTree&) = delete;
+        OrderedHandlerTree& operator=(const OrderedHandlerTree&) = delete;
+        OrderedHandlerTree& operator=(OrderedHandlerTree&&) = delete;
+
+        iterator begin() const
+        {
+            return iterator(m_anchor.mpNodeLeft);
+        }
+
+        iterator end() const
+        {
+            return iterator(const_cast<eastl::rbtree_node_base*>(&m_anchor));
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        Node& front() const
+        {
+            assert(!empty() && "OrderedHandlerTree is empty");
+            return *begin();
+        }
+
+        /// @brief Insert after the nodes which do not compare greater than node
+        void insert(Node& node)
+        {
+            eastl::rbtree_node_base* parent = &m_anchor;
+            eastl::rbtree_node_base* current = m_anchor.mpNodeParent;
+            bool left = true;
+            while (current)
+            {
+                parent = current;
+                left = Compare{}(node, *static_cast<Node*>(current));
+                current = left ? current->mpNodeLeft : current->mpNodeRight;
+            }
+
+            eastl::RBTreeInsert(&node, parent, &m_anchor, left ? eastl::kRBTreeSideLeft : eastl::kRBTreeSideRight);
+            ++m_size;
+        }
+
+        void erase(Node& node)
+        {
+            eastl::RBTreeErase(&node, &m_anchor);
+            --m_size;
+        }
+
+    private:
+        void Reset()
+        {
+            m_anchor.mpNodeRight = &m_anchor;
+            m_anchor.mpNodeLeft = &m_anchor;
+            m_anchor.mpNodeParent = nullptr;
+            m_anchor.mColor = eastl::kRBTreeColorRed;
+            m_size = 0;
+        }
+
+        eastl::rbtree_node_base m_anchor;   ///< end(), its parent is the root, left and right are the first and last nodes
+        size_t                  m_size {0};
+    };
+}
@@ -0,0 +1,465 @@
+#pragma once
+
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <cassert>
+
+#include <EASTL/vector.h>
+#include <EASTL/algorithm.h>
+
+#include "Log/SpdLogSystem.h"
+#include "CommandBuffer.h"
+
+namespace Spark
+{
+    /// @brief Commands queued by one thread, read by the thread executing the queue.
+    ///
+    /// Commands are appended to a chain of blocks and published with a release store, the producer never waits.
+    /// Blocks consumed by Execute are handed back through a lock free stack and reused by the producer.
+    template <typename Allocator>
+    class EBusProducerQueue
+    {
+    public:
+        /// Size of a block, a command larger than this gets a block of its own
+        static constexpr size_t BlockSize = 16 * 1024;
+
+        explicit EBusProducerQueue(const Allocator& allocator = Allocator())
+            : m_allocator(allocator)
+        {
+            m_head = m_tail = CreateBlock(BlockSize);
+        }
+
+        ~EBusProducerQueue()
+        {
+            Discard(Count());
+            for (Block* block = m_head; block;)
+            {
+                Block* next = block->m_next.load(std::memory_order_relaxed);
+                FreeBlock(block);
+                block = next;
+            }
+            for (Block* block = m_free.exchange(nullptr); block;)
+            {
+                Block* next = block->m_next.load(std::memory_order_relaxed);
+                FreeBlock(block);
+                block = next;
+            }
+        }
+
+        EBusProducerQueue(const EBusProducerQueue&) = delete;
+        EBusProducerQueue& operator=(const EBusProducerQueue&) = delete;
+
+        /// @brief Producer thread only
+        template <typename Function, typename... InputArgs>
+        void Push(uint64_t sequence, Function&& func, InputArgs&&... args)
+        {
+            const size_t size = EBusCommand::SizeOf<Function, InputArgs...>();
+            if (m_tailUsed + size > m_tail->m_capacity)
+            {
+                Block* block = AcquireBlock(size);
+                m_tail->m_next.store(block, std::memory_order_release);
+                m_tail = block;
+                m_tailUsed = 0;
+            }
+
+            EBusCommand::Construct(m_tail->Data() + m_tailUsed, sequence, eastl::forward<Function>(func), eastl::forward<InputArgs>(args)...);
+            m_tailUsed += size;
+            m_tail->m_committed.store(static_cast<uint32_t>(m_tailUsed), std::memory_order_release);
+            m_pushed.fetch_add(1, std::memory_order_release);
+        }
+
+        /// @brief Number of commands published and not consumed yet, consumer side
+        size_t Count() const
+        {
+            return m_pushed.load(std::memory_order_acquire) - m_consumed.load(std::memory_order_relaxed);
+        }
+
+        /// @brief The next command, there must be at least one published command
+        EBusCommand* Front()
+        {
+            assert(Count() > 0 && "EBusProducerQueue is empty");
+            if (m_headRead == m_head->m_committed.load(std::memory_order_acquire))
+            {
+                // 当前块已读完，生产者在写入下一个块前已链接到它
+                Block* next = m_head->m_next.load(std::memory_order_acquire);
+                ReleaseBlock(m_head);
+                m_head = next;
+                m_headRead = 0;
+            }
+            return reinterpret_cast<EBusCommand*>(m_head->Data() + m_headRead);
+        }
+
+        /// @brief Consume the command returned by Front, it stays valid until the next call to Front
+        void PopFront()
+        {
+            EBusCommand* command = reinterpret_cast<EBusCommand*>(m_head->Data() + m_headRead);
+            m_headRead += command->m_size;
+            m_consumed.store(m_consumed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        /// @brief Destroy the next count commands without calling them
+        void Discard(size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                EBusCommand* command = Front();
+                PopFront();
+                command->Destroy();
+            }
+        }
+
+    private:
+        struct Block
+        {
+            std::atomic<Block*>   m_next {nullptr};
+            std::atomic<uint32_t> m_committed {0};
+            size_t                m_capacity {0};
+
+            char* Data()
+            {
+                return reinterpret_cast<char*>(this) + EBusCommand::Align(sizeof(Block));
+            }
+        };
+
+        Block* CreateBlock(size_t capacity)
+        {
+            void* memory = m_allocator.allocate(EBusCommand::Align(sizeof(Block)) + capacity, alignof(std::max_align_t), 0);
+            Block* block = new (memory) Block();
+            block->m_capacity = capacity;
+            return block;
+        }
+
+        void FreeBlock(Block* block)
+        {
+            const size_t size = EBusCommand::Align(sizeof(Block)) + block->m_capacity;
+            block->~Block();
+            m_allocator.deallocate(block, size);
+        }
+
+        // 生产者一次取走所有回收的块
+        Block* AcquireBlock(size_t size)
+        {
+            if (!m_reusable)
+            {
+                m_reusable = m_free.exchange(nullptr, std::memory_order_acquire);
+            }
+
+            Block* block = nullptr;
+            if (size <= BlockSize && m_reusable)
+            {
+                block = m_reusable;
+                m_reusable = block->m_next.load(std::memory_order_relaxed);
+                block->m_next.store(nullptr, std::memory_order_relaxed);
+                block->m_committed.store(0, std::memory_order_relaxed);
+            }
+            else
+            {
+                block = CreateBlock(eastl::max(BlockSize, size));
+            }
+            return block;
+        }
+
+        void ReleaseBlock(Block* block)
+        {
+            if (block->m_capacity != BlockSize)
+            {
+                FreeBlock(block);
+                return;
+            }
+
+            Block* head = m_free.load(std::memory_order_relaxed);
+            do
+            {
+                block->m_next.store(head, std::memory_order_relaxed);
+            } while (!m_free.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        Allocator m_allocator;
+
+        // 生产者
+        Block*  m_tail {nullptr};
+        size_t  m_tailUsed {0};
+        Block*  m_reusable {nullptr};
+
+        // 消费者
+        Block*  m_head {nullptr};
+        size_t  m_headRead {0};
+
+        std::atomic<size_t> m_consumed {0};
+
+        std::atomic<size_t> m_pushed {0};
+        std::atomic<Block*> m_free {nullptr};
+    };
+
+    /// @brief Event queue where every producing thread appends to its own EBusProducerQueue, selected by
+    ///  EBusTraits::EventQueuePolicy.
+    ///
+    /// Queueing takes no lock once the thread has registered its queue. Execute runs the commands queued before
+    /// it was called, in order per producer; with Sequenced the producers are merged by a global sequence number,
+    /// so the commands run in the order they were queued across threads. A command still being queued when
+    /// Execute starts runs in the next Execute, even if its sequence number is smaller.
+    /// Producer queues live as long as the context, a thread that queued once keeps its queue. Each thread caches
+    /// the queues of the last four contexts of the bus it queued to, a thread alternating between more contexts
+    /// takes the producer lock to find its queue again.
+    template <typename Bus, bool Sequenced>
+    struct EBusPerThreadQueuePolicy
+    {
+        using ProducerQueue = EBusProducerQueue<typename Bus::AllocatorType>;
+        using BusMessageCall = EBusCommand;
+
+        EBusPerThreadQueuePolicy() = default;
+
+        ~EBusPerThreadQueuePolicy()
+        {
+            for (ProducerQueue* producer : m_producers)
+            {
+                delete producer;
+            }
+        }
+
+        EBusPerThreadQueuePolicy(const EBusPerThreadQueuePolicy&) = delete;
+        EBusPerThreadQueuePolicy& operator=(const EBusPerThreadQueuePolicy&) = delete;
+
+        std::atomic<bool> m_isActive {Bus::Traits::EventQueueingActiveByDefault};
+
+        template <typename Function, typename... InputArgs>
+        void Push(Function&& func, InputArgs&&... args)
+        {
+            ProducerQueue* producer = FindLocalProducer();
+            if (!producer)
+            {
+                producer = RegisterProducer();
+            }
+
+            uint64_t sequence = 0;
+            if constexpr (Sequenced)
+            {
+                sequence = m_sequence.fetch_add(1, std::memory_order_relaxed);
+            }
+            producer->Push(sequence, eastl::forward<Function>(func), eastl::forward<InputArgs>(args)...);
+        }
+
+        void Execute()
+        {
+            if (!m_isActive)
+            {
+                LOG_WARN("[EBus] You are calling execute queued functions on a bus which has not activated its function queuing!");
+            }
+
+            ConsumerScope scope(*this);
+            if (!scope.IsOwner())
+            {
+                return;
+            }
+
+            // 只执行调用Execute之前入队的事件，执行中入队的留到下一次
+            eastl::vector<eastl::pair<ProducerQueue*, size_t>> pending;
+            pending.reserve(scope.Producers().size());
+            for (ProducerQueue* producer : scope.Producers())
+            {
+                if (size_t count = producer->Count())
+                {
+                    pending.push_back({producer, count});
+                }
+            }
+
+            if constexpr (Sequenced)
+            {
+                while (!pending.empty())
+                {
+                    auto next = eastl::min_element(pending.begin(), pending.end(), [](const auto& a, const auto& b)
+                    {
+                        return a.first->Front()->m_sequence < b.first->Front()->m_sequence;
+                    });
+                    Run(*next->first);
+                    if (--next->second == 0)
+                    {
+                        pending.erase_unsorted(next);
+                    }
+                }
+            }
+            else
+            {
+                for (auto& [producer, count] : pending)
+                {
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        Run(*producer);
+                    }
+                }
+            }
+        }
+
+        void Clear()
+        {
+            ConsumerScope scope(*this);
+            if (scope.IsOwner())
+            {
+                for (ProducerQueue* producer : scope.Producers())
+                {
+                    producer->Discard(producer->Count());
+                }
+            }
+        }
+
+        void SetActive(bool isActive)
+        {
+            m_isActive = isActive;
+            if (!isActive)
+            {
+                Clear();
+            }
+        }
+
+        bool IsActive()
+        {
+            return m_isActive;
+        }
+
+        size_t Count()
+        {
+            std::lock_guard lock(m_producersMutex);
+            size_t count = 0;
+            for (ProducerQueue* producer : m_producers)
+            {
+                count += producer->Count();
+            }
+            return count;
+        }
+
+    private:
+        // 同一时间只有一个线程消费，同一线程嵌套的Execute直接返回
+        class ConsumerScope
+        {
+        public:
+            explicit ConsumerScope(EBusPerThreadQueuePolicy& queue) : m_queue(queue)
+            {
+                if (m_queue.m_consumer.load(std::memory_order_relaxed) == std::this_thread::get_id())
+                {
+                    LOG_WARN("[EBus] Queued events can not be executed from inside the execution of the same queue");
+                    return;
+                }
+
+                m_queue.m_consumerMutex.lock();
+                m_queue.m_consumer.store(std::this_thread::get_id(), std::memory_order_relaxed);
+                m_owner = true;
+
+                std::lock_guard lock(m_queue.m_producersMutex);
+                m_producers = m_queue.m_producers;
+            }
+
+            ~ConsumerScope()
+            {
+                if (m_owner)
+                {
+                    m_queue.m_consumer.store(std::thread::id(), std::memory_order_relaxed);
+                    m_queue.m_consumerMutex.unlock();
+                }
+            }
+
+            bool IsOwner() const
+            {
+                return m_owner;
+            }
+
+            const eastl::vector<ProducerQueue*>& Producers() const
+            {
+                return m_producers;
+            }
+
+        private:
+            EBusPerThreadQueuePolicy&     m_queue;
+            eastl::vector<ProducerQueue*> m_producers;
+            bool                          m_owner {false};
+        };
+
+        static void Run(ProducerQueue& producer)
+        {
+            EBusCommand* command = producer.Front();
+            producer.PopFront();
+            command->Invoke();
+            command->Destroy();
+        }
+
+        // 每个线程缓存最近使用的几个context的生产者队列，按context的id查找，不需要加锁
+        // id不会复用，context销毁后残留的缓存项不会再被命中
+        struct ProducerSlot
+        {
+            uint64_t       m_id {0};
+            ProducerQueue* m_producer {nullptr};
+        };
+
+        static constexpr size_t LocalProducerCount = 4;
+
+        struct LocalProducers
+        {
+            ProducerSlot m_slots[LocalProducerCount];
+            size_t       m_next {0};
+        };
+
+        static LocalProducers& GetLocalProducers()
+        {
+            static thread_local LocalProducers t_producers;
+            return t_producers;
+        }
+
+        static uint64_t NextId()
+        {
+            static std::atomic<uint64_t> s_nextId {1};
+            return s_nextId.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        ProducerQueue* FindLocalProducer() const
+        {
+            for (const ProducerSlot& slot : GetLocalProducers().m_slots)
+            {
+                if (slot.m_id == m_id)
+                {
+                    return slot.m_producer;
+                }
+            }
+            return nullptr;
+        }
+
+        /// @brief Find the queue of the calling thread, creating it on first use, and cache it in a local slot
+        ProducerQueue* RegisterProducer()
+        {
+            const std::thread::id thread = std::this_thread::get_id();
+            ProducerQueue* producer = nullptr;
+            {
+                std::lock_guard lock(m_producersMutex);
+                // 缓存项被其他context替换后，线程已有的队列仍在列表中
+                for (size_t index = 0; index < m_producers.size(); ++index)
+                {
+                    if (m_producerThreads[index] == thread)
+                    {
+                        producer = m_producers[index];
+                        break;
+                    }
+                }
+                if (!producer)
+                {
+                    producer = new ProducerQueue();
+                    m_producers.push_back(producer);
+                    m_producerThreads.push_back(thread);
+                }
+            }
+
+            LocalProducers& local = GetLocalProducers();
+            local.m_slots[local.m_next] = {m_id, producer};
+            local.m_next = (local.m_next + 1) % LocalProducerCount;
+            return producer;
+        }
+
+        const uint64_t                           m_id {NextId()};
+        eastl::vector<ProducerQueue*>            m_producers;
+        eastl::vector<std::thread::id>           m_producerThreads;     ///< Thread owning the queue of the same index
+        std::mutex                               m_producersMutex;
+        std::mutex                               m_consumerMutex;
+        std::atomic<std::thread::id>             m_consumer;
+        std::atomic<uint64_t>                    m_sequence {0};
+    };
+}
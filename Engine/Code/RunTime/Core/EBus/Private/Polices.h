@@ -1,11 +1,14 @@
 #pragma once
 
 #include <EASTL/functional.h>
-#include <EASTL/queue.h>
+#include <EASTL/list.h>
+#include <EASTL/vector.h>
 
 #include <mutex>
 
 #include "Log/SpdLogSystem.h"
+#include "EBus/EBusEnvironment.h"
+#include "CommandBuffer.h"
 
 namespace Spark
 {
@@ -23,6 +26,13 @@ namespace Spark
         MultipleAndOrdered,
     };
 
+    enum class EBusEventQueuePolicy
+    {
+        Shared,             ///< One command buffer shared by all the producers
+        PerThread,          ///< One queue per producing thread, executed in order per producer
+        PerThreadOrdered,   ///< One queue per producing thread, executed in the order the events were queued
+    };
+
     struct NullBusMessageCall
     {
         template<typename Function>
@@ -48,6 +58,28 @@ namespace Spark
         }
     };
 
+    /// 使用当前线程激活的EBusEnvironment中的context，没有激活的环境时使用全局context
+    template <typename Context>
+    struct EBusEnvironmentStoragePolicy
+    {
+        static Context* Get()
+        {
+            return &GetOrCreate();
+        }
+
+        static Context& GetOrCreate()
+        {
+            if (EBusEnvironment* environment = EBusEnvironment::GetCurrent())
+            {
+                if (Context* context = environment->GetOrCreateContext<Context>())
+                {
+                    return *context;
+                }
+            }
+            return EBusGlobalStoragePolicy<Context>::GetOrCreate();
+        }
+    };
+
     template <typename Context>
     struct EBusThreadLocalStoragePolicy
     {
@@ -77,17 +109,29 @@ namespace Spark
     template <typename Bus, typename MutexType>
     struct EBusQueuePolicy<true, Bus, MutexType>
     {
-        using BusMessageCall = eastl::function<void()>;
-       
-        using DequeType = eastl::deque<BusMessageCall, typename Bus::AllocatorType>;
-        using MessageQueueType = eastl::queue<BusMessageCall, DequeType>;
+        using CommandBuffer = EBusCommandBuffer<typename Bus::AllocatorType>;
+        using BusMessageCall = CommandBuffer;
 
-        EBusQueuePolicy() = default;
+        EBusQueuePolicy()
+        {
+            m_messages = &m_buffers[0];
+            m_freeBuffers.push_back(&m_buffers[1]);
+        }
+
+        EBusQueuePolicy(const EBusQueuePolicy&) = delete;
+        EBusQueuePolicy& operator=(const EBusQueuePolicy&) = delete;
 
         bool                 m_isActive = Bus::Traits::EventQueueingActiveByDefault;
-        MessageQueueType     m_messages;
+        CommandBuffer*       m_messages;        ///< Buffer the producers push to
         MutexType            m_messagesMutex; 
 
+        template <typename Function, typename... InputArgs>
+        void Push(Function&& func, InputArgs&&... args)
+        {
+            std::lock_guard<MutexType> lock(m_messagesMutex);
+            m_messages->Push(eastl::forward<Function>(func), eastl::forward<InputArgs>(args)...);
+        }
+
         void Execute()
         {
             if (!m_isActive)
@@ -95,27 +139,28 @@ namespace Spark
                 LOG_WARN("[EBus] You are calling execute queued functions on a bus which has not activated its function queuing!");
             }
 
-            MessageQueueType localMessages;
-
-            // Swap the current list of queue functions with a local instance
+            // Swap the buffer the producers push to, the calls are executed without holding the lock
+            CommandBuffer* localMessages = nullptr;
             {
-                std::unique_lock lock(m_messagesMutex);
-                eastl::swap(localMessages, m_messages);
+                std::lock_guard<MutexType> lock(m_messagesMutex);
+                if (m_messages->Empty())
+                {
+                    return;
+                }
+                localMessages = m_messages;
+                m_messages = AcquireBuffer();
             }
 
-            // Execute the queue functions safely now that are owned by the function
-            while (!localMessages.empty())
-            {
-                const BusMessageCall& localMessage = localMessages.front();
-                localMessage();
-                localMessages.pop();
-            }
+            localMessages->Execute();
+
+            std::lock_guard<MutexType> lock(m_messagesMutex);
+            m_freeBuffers.push_back(localMessages);
         }
 
         void Clear()
         {
             std::lock_guard<MutexType> lock(m_messagesMutex);
-            m_messages = {};
+            m_messages->Reset();
         }
 
         void SetActive(bool isActive)
@@ -124,7 +169,7 @@ namespace Spark
             m_isActive = isActive;
             if (!m_isActive)
             {
-                m_messages = {};
+                m_messages->Reset();
             }
         };
 
@@ -136,8 +181,25 @@ namespace Spark
         size_t Count()
         {
             std::lock_guard<MutexType> lock(m_messagesMutex);
-            return m_messages.size();
+            return m_messages->Count();
+        }
+
+    private:
+        // 两个缓冲区交替使用，Execute嵌套或并发时才会创建更多的缓冲区
+        CommandBuffer* AcquireBuffer()
+        {
+            if (m_freeBuffers.empty())
+            {
+                return &m_extraBuffers.emplace_back();
+            }
+            CommandBuffer* buffer = m_freeBuffers.back();
+            m_freeBuffers.pop_back();
+            return buffer;
         }
+
+        CommandBuffer                   m_buffers[2];
+        eastl::list<CommandBuffer>      m_extraBuffers;
+        eastl::vector<CommandBuffer*>   m_freeBuffers;
     };
 
     struct EBusEventProcessingPolicy
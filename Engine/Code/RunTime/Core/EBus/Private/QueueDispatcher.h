@@ -103,14 +103,7 @@ namespace Spark
             auto& context = Bus::GetOrCreateContext(false);
             if (context.m_queue.IsActive())
             {
-                std::scoped_lock<decltype(context.m_queue.m_messagesMutex)> messageLock(context.m_queue.m_messagesMutex);
-                context.m_queue.m_messages.push(typename Bus::QueuePolicy::BusMessageCall(
-                    [func = eastl::forward<Function>(func), args...]() mutable
-                    {
-                        eastl::invoke(eastl::forward<Function>(func), eastl::forward<InputArgs>(args)...);
-                    }
-                    )
-                );
+                context.m_queue.Push(eastl::forward<Function>(func), eastl::forward<InputArgs>(args)...);
             }
             else
             {
@@ -5,6 +5,8 @@
 #include <EASTL/map.h>
 
 #include "Polices.h"
+#include "OrderedHandlerTree.h"
+#include "FlatAddressMap.h"
 
 namespace Spark
 {
@@ -18,12 +20,11 @@ namespace Spark
     private:
         using IdType = typename Traits::BusIdType;
         
-    public:
-        struct StorageType: public eastl::unordered_map<IdType, HandlerHolder>
+        struct MapStorage: public eastl::unordered_map<IdType, HandlerHolder>
         {
             using Base = eastl::unordered_map<IdType, HandlerHolder>;
             
-            StorageType(): Base(typename Traits::AllocatorType()) {}
+            MapStorage(): Base(typename Traits::AllocatorType()) {}
 
             template <typename... InputArgs>
             typename Base::iterator emplace(InputArgs&&... args)
@@ -38,6 +39,17 @@ namespace Spark
                 Base::erase(id);
             }
         };
+
+        // HandlerHolder被BusPtr引用，FlatAddressMap保证其地址稳定
+        struct FlatStorage: public FlatAddressMap<IdType, HandlerHolder, typename Traits::AllocatorType>
+        {
+            using Base = FlatAddressMap<IdType, HandlerHolder, typename Traits::AllocatorType>;
+
+            FlatStorage(): Base(typename Traits::AllocatorType()) {}
+        };
+
+    public:
+        using StorageType = eastl::conditional_t<Traits::FlatAddressStorage, FlatStorage, MapStorage>;
     };
 
     template <typename Traits, typename HandlerHolder>
@@ -107,50 +119,60 @@ namespace Spark
     struct HandlerStoragePolicy<Interface, Traits, HandlerNode, EBusHandlerPolicy::MultipleAndOrdered>
     {
     private:
-        using Compare = HandlerCompare<Interface, Traits>;
+        using OrderKey = typename Traits::BusHandlerOrderKey;
+
+        // 有缓存的排序键时只比较键，否则调用BusHandlerOrderCompare
+        struct NodeCompare
+        {
+            bool operator()(const HandlerNode& left, const HandlerNode& right) const
+            {
+                if constexpr (eastl::is_void_v<OrderKey>)
+                {
+                    return HandlerCompare<Interface, Traits>{}(left, right);
+                }
+                else
+                {
+                    return left.m_orderKey < right.m_orderKey;
+                }
+            }
+        };
+
     public:
-        // 这里应该使用intrusive_multiset来实现，但是eastl没有这个容器，这里用intrusive_list来模拟
         struct StorageType
-            : public eastl::intrusive_list<HandlerNode>
+            : public OrderedHandlerTree<HandlerNode, NodeCompare>
         {
-            using Base = eastl::intrusive_list<HandlerNode>;
+            using Base = OrderedHandlerTree<HandlerNode, NodeCompare>;
 
             void insert(HandlerNode& elem)
             {
-                auto it = Base::begin();
-                while(it != Base::end())
+                if constexpr (!eastl::is_void_v<OrderKey>)
                 {
-                    if (Compare{}(elem, *it))
-                    {
-                        Base::insert(it, elem);
-                        return;
-                    }
-                    it++;
+                    elem.m_orderKey = Traits::GetHandlerOrderKey(elem.m_interface);
                 }
-
-                Base::push_back(elem);
-            }
-
-            void erase(HandlerNode& elem)
-            {
-                Base::remove(elem);
+                Base::insert(elem);
             }
         };
     };
 
     // HandlerStorageNode
-    template <typename Handler, EBusHandlerPolicy>
+    template <typename Handler, EBusHandlerPolicy, typename OrderKey = void>
     struct HandlerStorageNode
     {
     };
-    template <typename Handler>
-    struct HandlerStorageNode<Handler, EBusHandlerPolicy::Multiple>
+    template <typename Handler, typename OrderKey>
+    struct HandlerStorageNode<Handler, EBusHandlerPolicy::Multiple, OrderKey>
         : public eastl::intrusive_list_node
     {
     };
     template <typename Handler>
-    struct HandlerStorageNode<Handler, EBusHandlerPolicy::MultipleAndOrdered>
-        : public eastl::intrusive_list_node
+    struct HandlerStorageNode<Handler, EBusHandlerPolicy::MultipleAndOrdered, void>
+        : public OrderedHandlerTreeNode
+    {
+    };
+    template <typename Handler, typename OrderKey>
+    struct HandlerStorageNode<Handler, EBusHandlerPolicy::MultipleAndOrdered, OrderKey>
+        : public OrderedHandlerTreeNode
     {
+        OrderKey m_orderKey {};     ///< Traits::GetHandlerOrderKey of the handler, cached on connect
     };
 }
\ No newline at end of file
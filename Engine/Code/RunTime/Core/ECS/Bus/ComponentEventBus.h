@@ -15,6 +15,10 @@ namespace Spark
         static const EBusHandlerPolicy HandlerPolicy = EBusHandlerPolicy::Multiple;
         static const EBusAddressPolicy AddressPolicy = EBusAddressPolicy::ById;
 
+        // 每个世界在自己的EBusEnvironment中派发组件事件
+        template <typename Context>
+        using StoragePolicy = EBusEnvironmentStoragePolicy<Context>;
+
         using BusIdType = TypeId;
     
     public:
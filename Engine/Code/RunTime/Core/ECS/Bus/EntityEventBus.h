@@ -1,6 +1,7 @@
 #pragma once
 
 #include <EASTL/optional.h>
+#include <EASTL/span.h>
 
 #include <EBus/EBus.h>
 
@@ -16,10 +17,34 @@ namespace Spark
 
         static constexpr bool EnableEventQueue = true;
 
+        // 每个世界在自己的EBusEnvironment中派发实体事件
+        template <typename Context>
+        using StoragePolicy = EBusEnvironmentStoragePolicy<Context>;
+
     public:
         virtual void OnEntityCreate(Entity entity) = 0;
 
         virtual void OnEntityDestory(Entity entity) = 0;
+
+        /// @brief Called once for entities created by one bulk operation,
+        ///  the default implementation forwards every entity to OnEntityCreate
+        virtual void OnEntitiesCreate(eastl::span<const Entity> entities)
+        {
+            for (Entity entity : entities)
+            {
+                OnEntityCreate(entity);
+            }
+        }
+
+        /// @brief Called once for entities destoryed by one bulk operation before they are destoryed,
+        ///  the default implementation forwards every entity to OnEntityDestory
+        virtual void OnEntitiesDestory(eastl::span<const Entity> entities)
+        {
+            for (Entity entity : entities)
+            {
+                OnEntityDestory(entity);
+            }
+        }
     };
 
     using EntityEventBus = EBus<EntityEvent>;
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <atomic>
+
+#include <EASTL/vector.h>
+#include <EASTL/unique_ptr.h>
+#include <EASTL/algorithm.h>
+
+#include <entt/entt.hpp>
+
+#include "Entity.h"
+
+namespace Spark
+{
+    /// Entities whose component T was added or changed since the last WorldContext::AdvanceFrame
+    template<typename T>
+    struct ChangedFilter {};
+
+    /// Entities whose component T was added since the last WorldContext::AdvanceFrame
+    template<typename T>
+    struct AddedFilter {};
+
+    /// Entities whose component T was added or changed in or after m_frame
+    template<typename T>
+    struct ChangedSinceFilter
+    {
+        uint32_t m_frame {0};
+    };
+
+    /// @brief Position of one consumer in the change records of T. A query through the cursor returns the changes
+    ///  made since the previous query through the same cursor, whatever the order in which systems run in a frame.
+    ///  A new cursor returns every existing component once.
+    template<typename T>
+    struct ChangeCursor
+    {
+        uint32_t m_tick {0};
+    };
+
+    /// Entities whose component T was added or changed since the last query through the cursor
+    template<typename T>
+    struct ChangedCursorFilter
+    {
+        ChangeCursor<T>* m_cursor {nullptr};
+    };
+
+    /// Entities whose component T was added since the last query through the cursor
+    template<typename T>
+    struct AddedCursorFilter
+    {
+        ChangeCursor<T>* m_cursor {nullptr};
+    };
+
+    template<typename T>
+    inline constexpr ChangedFilter<T> Changed{};
+
+    template<typename T>
+    inline constexpr AddedFilter<T> Added{};
+
+    template<typename T>
+    ChangedSinceFilter<T> ChangedSince(uint32_t frame)
+    {
+        return ChangedSinceFilter<T>{frame};
+    }
+
+    template<typename T>
+    ChangedCursorFilter<T> ChangedSince(ChangeCursor<T>& cursor)
+    {
+        return ChangedCursorFilter<T>{&cursor};
+    }
+
+    template<typename T>
+    AddedCursorFilter<T> AddedSince(ChangeCursor<T>& cursor)
+    {
+        return AddedCursorFilter<T>{&cursor};
+    }
+
+    /// @brief Change records of one component type, enabled by WorldContext::TrackChanges.
+    ///
+    /// Everything is indexed by the entity index: the frame in which the component was added and last changed,
+    /// and the same two stamps as change ticks. The tick only advances when a ChangeCursor reads the records,
+    /// so every consumer sees each change once, no matter whether it runs before or after the writer.
+    /// Every 64 entities share the highest frame and tick stamped in them, a query skips the groups older than
+    /// what it asks for, so nothing has to be cleared when a frame starts. Marking an existing component changed
+    /// is thread safe; adding and removing components (the growth of the arrays) happens on the main thread.
+    class ChangeTracker
+    {
+    public:
+        explicit ChangeTracker(const uint32_t& frame) : m_frame(frame) {}
+
+        ChangeTracker(const ChangeTracker&) = delete;
+        ChangeTracker& operator=(const ChangeTracker&) = delete;
+
+        void OnConstruct([[maybe_unused]] entt::registry& registry, Entity entity)
+        {
+            const size_t index = ToIndex(entity);
+            Reserve(index + 1);
+            const uint32_t tick = m_tick.load(std::memory_order_relaxed);
+            m_entities[index] = entity;
+            m_addedFrames[index] = m_frame;
+            m_changedFrames[index] = m_frame;
+            m_addedTicks[index] = tick;
+            m_changedTicks[index] = tick;
+            StampGroup(index, tick);
+        }
+
+        void OnUpdate([[maybe_unused]] entt::registry& registry, Entity entity)
+        {
+            MarkChanged(entity);
+        }
+
+        void OnDestory([[maybe_unused]] entt::registry& registry, Entity entity)
+        {
+            const size_t index = ToIndex(entity);
+            if (index >= m_capacity)
+            {
+                return;
+            }
+            m_entities[index] = NullEntity;
+            m_addedFrames[index] = 0;
+            m_changedFrames[index] = 0;
+            m_addedTicks[index] = 0;
+            m_changedTicks[index] = 0;
+        }
+
+        /// @brief Thread safe for different entities, ignored if the entity does not have the component
+        void MarkChanged(Entity entity)
+        {
+            const size_t index = ToIndex(entity);
+            if (index >= m_capacity || m_entities[index] != entity)
+            {
+                return;
+            }
+            const uint32_t tick = m_tick.load(std::memory_order_relaxed);
+            m_changedFrames[index] = m_frame;
+            m_changedTicks[index] = tick;
+            StampGroup(index, tick);
+        }
+
+        /// @return 0 if the entity does not have the component
+        uint32_t GetAddedFrame(Entity entity) const
+        {
+            const size_t index = ToIndex(entity);
+            return index < m_capacity && m_entities[index] == entity ? m_addedFrames[index] : 0;
+        }
+
+        /// @return 0 if the entity does not have the component
+        uint32_t GetChangedFrame(Entity entity) const
+        {
+            const size_t index = ToIndex(entity);
+            return index < m_capacity && m_entities[index] == entity ? m_changedFrames[index] : 0;
+        }
+
+        template<typename Func>
+        void ForEachAdded(Func&& func) const
+        {
+            ForEachStamped(m_groupFrames.get(), m_addedFrames, m_frame, func);
+        }
+
+        template<typename Func>
+        void ForEachChanged(Func&& func) const
+        {
+            ForEachStamped(m_groupFrames.get(), m_changedFrames, m_frame, func);
+        }
+
+        template<typename Func>
+        void ForEachChangedSince(uint32_t frame, Func&& func) const
+        {
+            ForEachStamped(m_groupFrames.get(), m_changedFrames, eastl::max(frame, 1u), func);
+        }
+
+        /// @brief Visit the components added since the last read of the cursor and move the cursor forward.
+        ///  Must not run concurrently with writers of the component.
+        template<typename T, typename Func>
+        void ForEachAdded(ChangeCursor<T>& cursor, Func&& func)
+        {
+            ForEachStamped(m_groupTicks.get(), m_addedTicks, Advance(cursor), func);
+        }
+
+        /// @brief Visit the components changed since the last read of the cursor and move the cursor forward.
+        ///  Must not run concurrently with writers of the component.
+        template<typename T, typename Func>
+        void ForEachChanged(ChangeCursor<T>& cursor, Func&& func)
+        {
+            ForEachStamped(m_groupTicks.get(), m_changedTicks, Advance(cursor), func);
+        }
+
+    private:
+        static constexpr size_t GroupSize = 64;
+
+        static size_t ToIndex(Entity entity)
+        {
+            return static_cast<size_t>(entt::to_entity(entity));
+        }
+
+        static size_t GroupCount(size_t count)
+        {
+            return (count + GroupSize - 1) / GroupSize;
+        }
+
+        static void StampMax(std::atomic<uint32_t>& stamp, uint32_t value)
+        {
+            // 已是最新时避免写入共享的缓存行
+            uint32_t current = stamp.load(std::memory_order_relaxed);
+            while (current < value && !stamp.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        void StampGroup(size_t index, uint32_t tick)
+        {
+            StampMax(m_groupFrames[index / GroupSize], m_frame);
+            StampMax(m_groupTicks[index / GroupSize], tick);
+        }
+
+        /// @return the first tick the cursor has not read, later changes are stamped with a newer tick
+        template<typename T>
+        uint32_t Advance(ChangeCursor<T>& cursor)
+        {
+            const uint32_t since = cursor.m_tick;
+            cursor.m_tick = m_tick.fetch_add(1, std::memory_order_relaxed) + 1;
+            return since;
+        }
+
+        // 跳过最新标记早于since的组，再逐个检查组内的实体
+        template<typename Func>
+        void ForEachStamped(const std::atomic<uint32_t>* groups, const eastl::vector<uint32_t>& stamps,
+                            uint32_t since, Func& func) const
+        {
+            const size_t groupCount = GroupCount(m_capacity);
+            for (size_t group = 0; group < groupCount; ++group)
+            {
+                if (groups[group].load(std::memory_order_relaxed) < since)
+                {
+                    continue;
+                }
+                const size_t last = (group + 1) * GroupSize;
+                for (size_t index = group * GroupSize; index < last; ++index)
+                {
+                    if (stamps[index] >= since && m_entities[index] != NullEntity)
+                    {
+                        func(m_entities[index]);
+                    }
+                }
+            }
+        }
+
+        void Reserve(size_t count)
+        {
+            if (count <= m_capacity)
+            {
+                return;
+            }
+
+            const size_t capacity = GroupCount(eastl::max(count, m_capacity * 2)) * GroupSize;
+            m_entities.resize(capacity, NullEntity);
+            m_addedFrames.resize(capacity, 0);
+            m_changedFrames.resize(capacity, 0);
+            m_addedTicks.resize(capacity, 0);
+            m_changedTicks.resize(capacity, 0);
+            m_groupFrames = Grow(m_groupFrames.get(), m_capacity, capacity);
+            m_groupTicks = Grow(m_groupTicks.get(), m_capacity, capacity);
+            m_capacity = capacity;
+        }
+
+        static eastl::unique_ptr<std::atomic<uint32_t>[]> Grow(const std::atomic<uint32_t>* groups, size_t oldCapacity, size_t capacity)
+        {
+            const size_t oldGroups = GroupCount(oldCapacity);
+            const size_t groupCount = GroupCount(capacity);
+            eastl::unique_ptr<std::atomic<uint32_t>[]> result(new std::atomic<uint32_t>[groupCount]);
+            for (size_t group = 0; group < groupCount; ++group)
+            {
+                result[group].store(group < oldGroups ? groups[group].load(std::memory_order_relaxed) : 0, std::memory_order_relaxed);
+            }
+            return result;
+        }
+
+        const uint32_t& m_frame;
+        // 游标读取时前进，0留给没有记录的实体
+        std::atomic<uint32_t> m_tick {1};
+
+        // 按实体索引存储，m_capacity为64的倍数
+        size_t                                     m_capacity {0};
+        eastl::vector<Entity>                      m_entities;
+        eastl::vector<uint32_t>                    m_addedFrames;
+        eastl::vector<uint32_t>                    m_changedFrames;
+        eastl::vector<uint32_t>                    m_addedTicks;
+        eastl::vector<uint32_t>                    m_changedTicks;
+        eastl::unique_ptr<std::atomic<uint32_t>[]> m_groupFrames;   // 每组实体中最新的帧号
+        eastl::unique_ptr<std::atomic<uint32_t>[]> m_groupTicks;    // 每组实体中最新的tick
+    };
+}
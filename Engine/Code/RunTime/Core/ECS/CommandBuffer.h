@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <thread>
+
+#include <EASTL/vector.h>
+#include <EASTL/unique_ptr.h>
+#include <EASTL/algorithm.h>
+#include <EASTL/type_traits.h>
+
+#include <entt/entt.hpp>
+
+#include "Entity.h"
+#include "Reflection/RTTI.h"
+#include "Log/SpdLogSystem.h"
+
+namespace Spark
+{
+    /// @brief Tag of the reserved entities which are not played back yet. They only hold their identifiers in the registry,
+    ///  no view returns them as they have no other component, and WorldContext::Valid is false for them.
+    struct ReservedEntity {};
+
+    /// @brief Entity IDs created ahead of time, so command buffers can hand out entities without touching the registry.
+    ///  The identifiers are held by ReservedEntity tagged entities, the tag is removed and the create events are sent
+    ///  when the create commands are played back. Entities taken by a buffer which is reset before playback go back to the pool.
+    struct EntityReservation
+    {
+        /// @brief Thread safe
+        /// @return NullEntity if the reservation is used up
+        Entity Take()
+        {
+            const size_t index = m_next.fetch_add(1, std::memory_order_relaxed);
+            return index < m_entities.size() ? m_entities[index] : NullEntity;
+        }
+
+        /// @brief Number of entities taken since the last sync point
+        size_t GetUsedCount() const
+        {
+            return eastl::min(m_next.load(std::memory_order_relaxed), m_entities.size());
+        }
+
+        // 只在同步点修改
+        eastl::vector<Entity> m_entities;
+        std::atomic<size_t>   m_next {0};
+    };
+
+    /// @brief Records structural changes of a WorldContext from one thread, see WorldContext::GetCommandBuffer.
+    ///
+    /// Commands are appended to a vector and component values are moved into a linear arena, both are reused
+    /// after every playback. WorldContext::PlaybackCommands applies the commands of all buffers at the sync point.
+    class CommandBuffer
+    {
+    public:
+        enum class CommandType : uint8_t
+        {
+            Create,
+            Add,
+            Remove,
+            Destory
+        };
+
+        struct Command
+        {
+            using ApplyFunc = void (*)(entt::registry&, Entity, void*);
+            using DestroyFunc = void (*)(void*);
+
+            CommandType m_type {CommandType::Create};
+            TypeId      m_component {0};
+            Entity      m_entity {NullEntity};
+            ApplyFunc   m_apply {nullptr};
+            DestroyFunc m_destroy {nullptr};
+            void*       m_payload {nullptr};
+        };
+
+        CommandBuffer(EntityReservation& reservation, std::thread::id owner)
+            : m_reservation(reservation), m_owner(owner)
+        {
+        }
+
+        ~CommandBuffer()
+        {
+            Reset();
+        }
+
+        CommandBuffer(const CommandBuffer&) = delete;
+        CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+        /// @brief Take a reserved entity, components can be added to it right away through this buffer
+        /// @return NullEntity if the reservation of the context is used up
+        Entity CreateEntity()
+        {
+            const Entity entity = m_reservation.Take();
+            if (entity == NullEntity)
+            {
+                LOG_ERROR("[CommandBuffer] CreateEntity: entity reservation is used up, call WorldContext::ReserveEntities first");
+                return entity;
+            }
+
+            Command& command = m_commands.push_back();
+            command.m_type = CommandType::Create;
+            command.m_entity = entity;
+            return entity;
+        }
+
+        void DestoryEntity(Entity entity)
+        {
+            Command& command = m_commands.push_back();
+            command.m_type = CommandType::Destory;
+            command.m_entity = entity;
+        }
+
+        /// @brief Add or replace the component at playback
+        template<typename T, typename... Args>
+        void Add(Entity entity, Args&&... args)
+        {
+            static_assert(alignof(T) <= alignof(std::max_align_t), "CommandBuffer does not support over-aligned components");
+
+            Command& command = m_commands.push_back();
+            command.m_type = CommandType::Add;
+            command.m_component = GetTypeId<T>();
+            command.m_entity = entity;
+            if constexpr (eastl::is_empty_v<T>)
+            {
+                command.m_apply = [](entt::registry& registry, Entity target, void*)
+                {
+                    registry.emplace_or_replace<T>(target);
+                };
+            }
+            else
+            {
+                command.m_payload = new (Allocate(sizeof(T), alignof(T))) T{eastl::forward<Args>(args)...};
+                command.m_apply = [](entt::registry& registry, Entity target, void* payload)
+                {
+                    registry.emplace_or_replace<T>(target, eastl::move(*static_cast<T*>(payload)));
+                };
+                if constexpr (!eastl::is_trivially_destructible_v<T>)
+                {
+                    command.m_destroy = [](void* payload)
+                    {
+                        static_cast<T*>(payload)->~T();
+                    };
+                }
+            }
+        }
+
+        template<typename T>
+        void Remove(Entity entity)
+        {
+            Command& command = m_commands.push_back();
+            command.m_type = CommandType::Remove;
+            command.m_component = GetTypeId<T>();
+            command.m_entity = entity;
+            command.m_apply = [](entt::registry& registry, Entity target, void*)
+            {
+                registry.remove<T>(target);
+            };
+        }
+
+        bool Empty() const
+        {
+            return m_commands.empty();
+        }
+
+        size_t GetCommandCount() const
+        {
+            return m_commands.size();
+        }
+
+        const eastl::vector<Command>& GetCommands() const
+        {
+            return m_commands;
+        }
+
+        std::thread::id GetOwner() const
+        {
+            return m_owner;
+        }
+
+        /// @brief Drop all commands and rewind the arena, the memory is kept for the next frame
+        void Reset()
+        {
+            for (Command& command : m_commands)
+            {
+                if (command.m_destroy)
+                {
+                    command.m_destroy(command.m_payload);
+                }
+            }
+            m_commands.clear();
+            m_blockIndex = 0;
+            m_blockOffset = 0;
+        }
+
+    private:
+        static constexpr size_t BlockSize = 16 * 1024;
+
+        struct Block
+        {
+            eastl::unique_ptr<std::byte[]> m_data;
+            size_t                         m_size {0};
+        };
+
+        void* Allocate(size_t size, size_t alignment)
+        {
+            while (m_blockIndex < m_blocks.size())
+            {
+                Block& block = m_blocks[m_blockIndex];
+                const size_t offset = (m_blockOffset + alignment - 1) & ~(alignment - 1);
+                if (offset + size <= block.m_size)
+                {
+                    m_blockOffset = offset + size;
+                    return block.m_data.get() + offset;
+                }
+                ++m_blockIndex;
+                m_blockOffset = 0;
+            }
+
+            // 超过块大小的组件单独分配一块
+            Block& block = m_blocks.push_back();
+            block.m_size = eastl::max(BlockSize, size);
+            block.m_data.reset(new std::byte[block.m_size]);
+            m_blockOffset = size;
+            return block.m_data.get();
+        }
+
+        EntityReservation&     m_reservation;
+        std::thread::id        m_owner;
+        eastl::vector<Command> m_commands;
+
+        // 线性分配组件数据，m_blocks[m_blockIndex]为当前块
+        eastl::vector<Block> m_blocks;
+        size_t               m_blockIndex {0};
+        size_t               m_blockOffset {0};
+    };
+}
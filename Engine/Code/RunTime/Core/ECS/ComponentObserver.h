@@ -0,0 +1,120 @@
+#pragma once
+
+#include <EASTL/span.h>
+
+#include "Entity.h"
+#include "EntityMap.h"
+#include "WorldContext.h"
+
+namespace Spark
+{
+    /// @brief Collect entities whose component has been constructed, updated or destoryed in a WorldContext.
+    ///
+    /// The observer connects to the signals of the component storage directly, so an event costs an inlined
+    /// set insertion instead of a dispatch through ComponentEventBus. The owner usually reads the collected
+    /// entities once per frame and then calls Clear.
+    ///
+    /// An entity is recorded in only one of the sets: an entity constructed and then updated stays in
+    /// the constructed set, and a destoryed entity is removed from the other two sets.
+    /// Like ComponentEventBus, only AddOrRepalce and Repalce trigger update events.
+    template<typename Component>
+    class ComponentObserver final
+    {
+    public:
+        ComponentObserver() = default;
+
+        ~ComponentObserver()
+        {
+            Disconnect();
+        }
+
+        ComponentObserver(const ComponentObserver&) = delete;
+        ComponentObserver& operator=(const ComponentObserver&) = delete;
+
+        void Connect(WorldContext& context)
+        {
+            if (m_context)
+            {
+                return;
+            }
+
+            m_context = &context;
+            m_context->ConnectObserver<Component>(*this);
+        }
+
+        void Disconnect()
+        {
+            if (!m_context)
+            {
+                return;
+            }
+
+            m_context->DisconnectObserver<Component>(*this);
+            m_context = nullptr;
+            Clear();
+        }
+
+        bool IsConnected() const
+        {
+            return m_context != nullptr;
+        }
+
+        eastl::span<const Entity> GetConstructed() const
+        {
+            return m_constructed.Entities();
+        }
+
+        eastl::span<const Entity> GetUpdated() const
+        {
+            return m_updated.Entities();
+        }
+
+        /// @brief Entities destoryed since last Clear, they may have been destoryed together with the component
+        eastl::span<const Entity> GetDestoryed() const
+        {
+            return m_destoryed.Entities();
+        }
+
+        bool Empty() const
+        {
+            return m_constructed.Empty() && m_updated.Empty() && m_destoryed.Empty();
+        }
+
+        void Clear()
+        {
+            m_constructed.Clear();
+            m_updated.Clear();
+            m_destoryed.Clear();
+        }
+
+    private:
+        friend class WorldContext;
+
+        void OnConstruct(entt::registry&, entt::entity entity)
+        {
+            m_destoryed.Erase(entity);
+            m_constructed.Insert(entity);
+        }
+
+        void OnUpdate(entt::registry&, entt::entity entity)
+        {
+            if (!m_constructed.Contains(entity))
+            {
+                m_updated.Insert(entity);
+            }
+        }
+
+        void OnDestory(entt::registry&, entt::entity entity)
+        {
+            m_constructed.Erase(entity);
+            m_updated.Erase(entity);
+            m_destoryed.Insert(entity);
+        }
+
+        WorldContext* m_context {nullptr};
+
+        EntitySet m_constructed;
+        EntitySet m_updated;
+        EntitySet m_destoryed;
+    };
+}
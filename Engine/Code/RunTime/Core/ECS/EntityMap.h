@@ -0,0 +1,286 @@
+#pragma once
+
+#include <cassert>
+
+#include <EASTL/vector.h>
+#include <EASTL/array.h>
+#include <EASTL/unique_ptr.h>
+#include <EASTL/span.h>
+#include <EASTL/utility.h>
+
+#include "Entity.h"
+
+namespace Spark
+{
+    /// @brief A set of entities keyed by the entity index of entt.
+    ///
+    /// A paged sparse array maps the entity index to a position in a packed entity array, so lookup,
+    /// insertion and erasure are array indexing instead of hashing. The packed array stores the full
+    /// entity identifier, an entity with the same index but another version (a recycled entity) is
+    /// not considered to be in the set.
+    ///
+    /// Erasure swaps the last entity into the hole, so the order of Entities() is not stable.
+    template<size_t PageSize = 4096>
+    class BasicEntitySet
+    {
+        static_assert((PageSize & (PageSize - 1)) == 0, "PageSize must be a power of two");
+
+        using Traits = entt::entt_traits<Entity>;
+        using Page = eastl::array<uint32_t, PageSize>;
+
+    public:
+        static constexpr uint32_t NPos = ~uint32_t(0);
+
+        BasicEntitySet() = default;
+        ~BasicEntitySet() = default;
+
+        BasicEntitySet(const BasicEntitySet&) = delete;
+        BasicEntitySet& operator=(const BasicEntitySet&) = delete;
+
+        BasicEntitySet(BasicEntitySet&&) = default;
+        BasicEntitySet& operator=(BasicEntitySet&&) = default;
+
+        bool Contains(Entity entity) const
+        {
+            return Index(entity) != NPos;
+        }
+
+        /// @brief Get the position of the entity in Entities()
+        /// @return NPos if the entity is not in the set
+        uint32_t Index(Entity entity) const
+        {
+            if (entity == NullEntity)
+            {
+                return NPos;
+            }
+
+            const size_t key = Traits::to_entity(entity);
+            const size_t page = key / PageSize;
+            if (page >= m_sparse.size() || !m_sparse[page])
+            {
+                return NPos;
+            }
+
+            const uint32_t index = (*m_sparse[page])[key & (PageSize - 1)];
+            return (index != NPos && m_packed[index] == entity) ? index : NPos;
+        }
+
+        /// @brief Insert an entity, a stale version of the same entity index is replaced
+        /// @return pair.first -- position of the entity, pair.second -- false if the entity was already in the set
+        eastl::pair<uint32_t, bool> Insert(Entity entity)
+        {
+            assert(entity != NullEntity && "[EntitySet] Can not insert a null entity");
+
+            uint32_t& slot = Assure(Traits::to_entity(entity));
+            if (slot != NPos)
+            {
+                const bool inserted = m_packed[slot] != entity;
+                m_packed[slot] = entity;
+                return {slot, inserted};
+            }
+
+            slot = static_cast<uint32_t>(m_packed.size());
+            m_packed.push_back(entity);
+            return {slot, true};
+        }
+
+        /// @brief Erase an entity, the last entity is moved to its position
+        /// @return The position of the erased entity, NPos if the entity is not in the set
+        uint32_t Erase(Entity entity)
+        {
+            const uint32_t index = Index(entity);
+            if (index == NPos)
+            {
+                return NPos;
+            }
+
+            const Entity last = m_packed.back();
+            m_packed[index] = last;
+            SparseRef(Traits::to_entity(last)) = index;
+            SparseRef(Traits::to_entity(entity)) = NPos;
+            m_packed.pop_back();
+            return index;
+        }
+
+        void Reserve(size_t capacity)
+        {
+            m_packed.reserve(capacity);
+        }
+
+        /// @brief Remove all entities, the sparse pages are kept for reuse
+        void Clear()
+        {
+            for (Entity entity : m_packed)
+            {
+                SparseRef(Traits::to_entity(entity)) = NPos;
+            }
+            m_packed.clear();
+        }
+
+        size_t Size() const
+        {
+            return m_packed.size();
+        }
+
+        bool Empty() const
+        {
+            return m_packed.empty();
+        }
+
+        eastl::span<const Entity> Entities() const
+        {
+            return eastl::span<const Entity>(m_packed.data(), m_packed.size());
+        }
+
+        auto begin() const { return m_packed.begin(); }
+        auto end() const { return m_packed.end(); }
+
+    private:
+        uint32_t& SparseRef(size_t key)
+        {
+            return (*m_sparse[key / PageSize])[key & (PageSize - 1)];
+        }
+
+        uint32_t& Assure(size_t key)
+        {
+            const size_t page = key / PageSize;
+            if (page >= m_sparse.size())
+            {
+                m_sparse.resize(page + 1);
+            }
+
+            if (!m_sparse[page])
+            {
+                m_sparse[page] = eastl::make_unique<Page>();
+                m_sparse[page]->fill(NPos);
+            }
+
+            return SparseRef(key);
+        }
+
+        eastl::vector<eastl::unique_ptr<Page>> m_sparse;
+        eastl::vector<Entity> m_packed;
+    };
+
+    /// @brief A map from entity to value, the values are packed in the same order as Entities()
+    template<typename T, size_t PageSize = 4096>
+    class BasicEntityMap
+    {
+        using Set = BasicEntitySet<PageSize>;
+
+    public:
+        static constexpr uint32_t NPos = Set::NPos;
+
+        bool Contains(Entity entity) const
+        {
+            return m_set.Contains(entity);
+        }
+
+        T* Find(Entity entity)
+        {
+            const uint32_t index = m_set.Index(entity);
+            return index != NPos ? &m_values[index] : nullptr;
+        }
+
+        const T* Find(Entity entity) const
+        {
+            const uint32_t index = m_set.Index(entity);
+            return index != NPos ? &m_values[index] : nullptr;
+        }
+
+        /// @brief Construct the value if the entity is not in the map, otherwise return the existing value
+        template<typename... Args>
+        eastl::pair<T*, bool> TryEmplace(Entity entity, Args&&... args)
+        {
+            auto [index, inserted] = m_set.Insert(entity);
+            if (index == m_values.size())
+            {
+                m_values.emplace_back(eastl::forward<Args>(args)...);
+            }
+            else if (inserted)
+            {
+                // 替换同一索引下已失效版本的实体
+                m_values[index] = T(eastl::forward<Args>(args)...);
+            }
+            return {&m_values[index], inserted};
+        }
+
+        template<typename V>
+        T& InsertOrAssign(Entity entity, V&& value)
+        {
+            auto [ptr, inserted] = TryEmplace(entity, eastl::forward<V>(value));
+            if (!inserted)
+            {
+                *ptr = eastl::forward<V>(value);
+            }
+            return *ptr;
+        }
+
+        T& operator[](Entity entity)
+        {
+            return *TryEmplace(entity).first;
+        }
+
+        bool Erase(Entity entity)
+        {
+            const uint32_t index = m_set.Erase(entity);
+            if (index == NPos)
+            {
+                return false;
+            }
+
+            if (index != m_values.size() - 1)
+            {
+                m_values[index] = eastl::move(m_values.back());
+            }
+            m_values.pop_back();
+            return true;
+        }
+
+        void Reserve(size_t capacity)
+        {
+            m_set.Reserve(capacity);
+            m_values.reserve(capacity);
+        }
+
+        void Clear()
+        {
+            m_set.Clear();
+            m_values.clear();
+        }
+
+        size_t Size() const
+        {
+            return m_set.Size();
+        }
+
+        bool Empty() const
+        {
+            return m_set.Empty();
+        }
+
+        eastl::span<const Entity> Entities() const
+        {
+            return m_set.Entities();
+        }
+
+        eastl::span<T> Values()
+        {
+            return eastl::span<T>(m_values.data(), m_values.size());
+        }
+
+        eastl::span<const T> Values() const
+        {
+            return eastl::span<const T>(m_values.data(), m_values.size());
+        }
+
+    private:
+        Set m_set;
+        eastl::vector<T> m_values;
+    };
+
+    using EntitySet = BasicEntitySet<>;
+
+    template<typename T>
+    using EntityMap = BasicEntityMap<T>;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <new>
+
+#include <EASTL/vector.h>
+#include <EASTL/algorithm.h>
+#include <EASTL/type_traits.h>
+
+#include <entt/entt.hpp>
+
+#include "Entity.h"
+#include "SoAStorage.h"
+#include "Reflection/RTTI.h"
+
+namespace Spark
+{
+    /// @brief A set of component values, instantiated in bulk by WorldContext::Instantiate.
+    ///
+    /// Every component is one column: the value is kept by the prefab and copied into the storage of the
+    /// component for all instances at once. The storage is reserved once, entt still copy constructs the instances
+    /// one by one.
+    class Prefab
+    {
+    public:
+        struct Column
+        {
+            using InsertFunc = void (*)(entt::registry&, const Entity*, const Entity*, const void*);
+            using CloneFunc = void* (*)(const void*);
+            using DestroyFunc = void (*)(void*);
+
+            TypeId      m_typeId {0};
+            void*       m_value {nullptr};
+            InsertFunc  m_insert {nullptr};
+            CloneFunc   m_clone {nullptr};
+            DestroyFunc m_destroy {nullptr};
+        };
+
+        Prefab() = default;
+
+        ~Prefab()
+        {
+            Clear();
+        }
+
+        Prefab(const Prefab& other)
+        {
+            *this = other;
+        }
+
+        Prefab& operator=(const Prefab& other)
+        {
+            if (this != &other)
+            {
+                Clear();
+                m_columns.reserve(other.m_columns.size());
+                for (const Column& column : other.m_columns)
+                {
+                    m_columns.push_back(column);
+                    m_columns.back().m_value = column.m_value ? column.m_clone(column.m_value) : nullptr;
+                }
+            }
+            return *this;
+        }
+
+        Prefab(Prefab&& other) noexcept : m_columns(eastl::move(other.m_columns))
+        {
+            other.m_columns.clear();
+        }
+
+        Prefab& operator=(Prefab&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Clear();
+                m_columns = eastl::move(other.m_columns);
+                other.m_columns.clear();
+            }
+            return *this;
+        }
+
+        /// @brief Set the value of a component, replacing the old value if the prefab already has it
+        template<typename T, typename... Args>
+        void Set(Args&&... args)
+        {
+            static_assert(!IsSoAComponent<T>, "SoA components can not be put in a prefab");
+
+            Column* column = Find(GetTypeId<T>());
+            if (!column)
+            {
+                column = &m_columns.push_back();
+                column->m_typeId = GetTypeId<T>();
+                column->m_insert = &InsertColumn<T>;
+                column->m_clone = &CloneValue<T>;
+                column->m_destroy = &DestroyValue<T>;
+            }
+            else if (column->m_value)
+            {
+                column->m_destroy(column->m_value);
+                column->m_value = nullptr;
+            }
+
+            // 空类型不保存值
+            if constexpr (!eastl::is_empty_v<T>)
+            {
+                column->m_value = new (AllocateValue<T>()) T{eastl::forward<Args>(args)...};
+            }
+        }
+
+        template<typename T>
+        void Remove()
+        {
+            auto it = eastl::find_if(m_columns.begin(), m_columns.end(),
+                [](const Column& column) { return column.m_typeId == GetTypeId<T>(); });
+            if (it != m_columns.end())
+            {
+                if (it->m_value)
+                {
+                    it->m_destroy(it->m_value);
+                }
+                m_columns.erase(it);
+            }
+        }
+
+        template<typename T>
+        bool Has() const
+        {
+            return Find(GetTypeId<T>()) != nullptr;
+        }
+
+        /// @return nullptr if the prefab does not have the component or it is an empty type
+        template<typename T>
+        const T* Get() const
+        {
+            const Column* column = Find(GetTypeId<T>());
+            return column ? static_cast<const T*>(column->m_value) : nullptr;
+        }
+
+        size_t GetComponentCount() const
+        {
+            return m_columns.size();
+        }
+
+        const eastl::vector<Column>& GetColumns() const
+        {
+            return m_columns;
+        }
+
+        void Clear()
+        {
+            for (Column& column : m_columns)
+            {
+                if (column.m_value)
+                {
+                    column.m_destroy(column.m_value);
+                }
+            }
+            m_columns.clear();
+        }
+
+    private:
+        Column* Find(TypeId typeId)
+        {
+            auto it = eastl::find_if(m_columns.begin(), m_columns.end(),
+                [typeId](const Column& column) { return column.m_typeId == typeId; });
+            return it != m_columns.end() ? it : nullptr;
+        }
+
+        const Column* Find(TypeId typeId) const
+        {
+            return const_cast<Prefab*>(this)->Find(typeId);
+        }
+
+        template<typename T>
+        static void InsertColumn(entt::registry& registry, const Entity* first, const Entity* last, const void* value)
+        {
+            auto& storage = registry.storage<T>();
+            storage.reserve(storage.size() + static_cast<size_t>(last - first));
+            if constexpr (eastl::is_empty_v<T>)
+            {
+                storage.insert(first, last);
+            }
+            else
+            {
+                storage.insert(first, last, *static_cast<const T*>(value));
+            }
+        }
+
+        template<typename T>
+        static void* AllocateValue()
+        {
+            return ::operator new(sizeof(T), std::align_val_t(alignof(T)));
+        }
+
+        template<typename T>
+        static void* CloneValue(const void* value)
+        {
+            return new (AllocateValue<T>()) T(*static_cast<const T*>(value));
+        }
+
+        template<typename T>
+        static void DestroyValue(void* value)
+        {
+            static_cast<T*>(value)->~T();
+            ::operator delete(value, std::align_val_t(alignof(T)));
+        }
+
+        eastl::vector<Column> m_columns;
+    };
+}
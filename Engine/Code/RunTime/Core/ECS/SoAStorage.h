@@ -0,0 +1,327 @@
+#pragma once
+
+#include <new>
+#include <tuple>
+#include <cstring>
+#include <utility>
+
+#include <EASTL/type_traits.h>
+#include <EASTL/algorithm.h>
+
+#include <entt/entt.hpp>
+
+#include "Entity.h"
+
+namespace Spark
+{
+    /// @brief Specialize for a trivially copyable component to store it as structure of arrays:
+    ///  template<> struct SoATraits<Position> : SoAFields<&Position::x, &Position::y, &Position::z> {};
+    ///  The component is then added with WorldContext::AddSoA instead of Add.
+    template<typename T>
+    struct SoATraits
+    {
+        static constexpr bool Enabled = false;
+    };
+
+    /// @brief The data members of a component stored in their own arrays, in the order of the streams
+    template<auto... MemberPointers>
+    struct SoAFields
+    {
+        static constexpr bool Enabled = true;
+        static constexpr auto Members = std::make_tuple(MemberPointers...);
+    };
+
+    template<typename T>
+    inline constexpr bool IsSoAComponent = SoATraits<T>::Enabled;
+
+    /// @brief Type erased part of SoAStorage used by WorldContext
+    class ISoAStorage
+    {
+    public:
+        virtual ~ISoAStorage() = default;
+
+        virtual bool Contains(Entity entity) const = 0;
+
+        virtual void Remove(Entity entity) = 0;
+
+        virtual void Clear() = 0;
+    };
+
+    /// @brief Structure-of-arrays storage of a component declared by SoATraits.
+    ///
+    /// Every field lives in its own array aligned to Alignment bytes, element i of all the streams belongs to
+    /// Entities()[i]. The capacity is a multiple of Lanes elements, so a kernel may process whole SIMD registers
+    /// up to AlignedSize() without a scalar tail; the padding elements are left uninitialized.
+    /// Removing an element moves the last one into its slot.
+    template<typename T>
+    class SoAStorage final : public ISoAStorage
+    {
+        using Traits = SoATraits<T>;
+        static_assert(Traits::Enabled, "SoATraits is not specialized for the component");
+        static_assert(eastl::is_trivially_copyable_v<T>, "SoAStorage only stores trivially copyable components");
+
+        static constexpr size_t FieldCount = std::tuple_size_v<eastl::remove_cv_t<decltype(Traits::Members)>>;
+
+        template<size_t Index>
+        using FieldType = eastl::remove_cvref_t<decltype(eastl::declval<T&>().*std::get<Index>(Traits::Members))>;
+
+        template<typename Field>
+        class AlignedArray
+        {
+        public:
+            AlignedArray() = default;
+            AlignedArray(const AlignedArray&) = delete;
+            AlignedArray& operator=(const AlignedArray&) = delete;
+
+            ~AlignedArray()
+            {
+                if (m_data)
+                {
+                    ::operator delete(m_data, std::align_val_t(Alignment));
+                }
+            }
+
+            void Grow(size_t capacity, size_t size)
+            {
+                Field* data = static_cast<Field*>(::operator new(capacity * sizeof(Field), std::align_val_t(Alignment)));
+                if (m_data)
+                {
+                    std::memcpy(data, m_data, size * sizeof(Field));
+                    ::operator delete(m_data, std::align_val_t(Alignment));
+                }
+                m_data = data;
+            }
+
+            Field* Data() const
+            {
+                return m_data;
+            }
+
+        private:
+            Field* m_data {nullptr};
+        };
+
+        template<size_t... Index>
+        static auto MakeArrays(std::index_sequence<Index...>) -> std::tuple<AlignedArray<FieldType<Index>>...>;
+
+        using Arrays = decltype(MakeArrays(std::make_index_sequence<FieldCount>{}));
+
+    public:
+        /// Alignment of every stream, enough for AVX-512 loads
+        static constexpr size_t Alignment = 64;
+
+        /// The capacity is a multiple of this number of elements
+        static constexpr size_t Lanes = 16;
+
+        SoAStorage() = default;
+        SoAStorage(const SoAStorage&) = delete;
+        SoAStorage& operator=(const SoAStorage&) = delete;
+
+        bool Contains(Entity entity) const override
+        {
+            return m_entities.contains(entity);
+        }
+
+        void Emplace(Entity entity, const T& value)
+        {
+            if (m_entities.contains(entity))
+            {
+                Set(entity, value);
+                return;
+            }
+
+            const size_t index = m_entities.size();
+            if (index == m_capacity)
+            {
+                Reserve(eastl::max<size_t>(m_capacity * 2, Lanes));
+            }
+            m_entities.push(entity);
+            Store(index, value, std::make_index_sequence<FieldCount>{});
+        }
+
+        void Remove(Entity entity) override
+        {
+            if (!m_entities.contains(entity))
+            {
+                return;
+            }
+
+            // 与entt的swap_and_pop一致，最后一个元素移到被删除的位置
+            const size_t index = m_entities.index(entity);
+            const size_t last = m_entities.size() - 1;
+            if (index != last)
+            {
+                Move(last, index, std::make_index_sequence<FieldCount>{});
+            }
+            m_entities.erase(entity);
+        }
+
+        void Clear() override
+        {
+            m_entities.clear();
+        }
+
+        void Reserve(size_t capacity)
+        {
+            capacity = (capacity + Lanes - 1) / Lanes * Lanes;
+            if (capacity <= m_capacity)
+            {
+                return;
+            }
+
+            std::apply([this, capacity](auto&... arrays) { (arrays.Grow(capacity, m_entities.size()), ...); }, m_arrays);
+            m_entities.reserve(capacity);
+            m_capacity = capacity;
+        }
+
+        /// @brief Reorder the elements so the entities shared with other come first, in the order of other.
+        ///  When both storages hold the same entities, element i of both belongs to the same entity afterwards,
+        ///  so a kernel can zip their streams.
+        template<typename Other>
+        void MatchOrder(const SoAStorage<Other>& other)
+        {
+            size_t position = 0;
+            const Entity* entities = other.Entities();
+            for (size_t i = 0; i < other.Size(); ++i)
+            {
+                const Entity entity = entities[i];
+                if (!m_entities.contains(entity))
+                {
+                    continue;
+                }
+
+                const size_t index = m_entities.index(entity);
+                if (index != position)
+                {
+                    Swap(index, position, std::make_index_sequence<FieldCount>{});
+                    m_entities.swap_elements(entity, m_entities.data()[position]);
+                }
+                ++position;
+            }
+        }
+
+        /// @brief Gather the fields of the entity into a component
+        T Get(Entity entity) const
+        {
+            return Load(m_entities.index(entity), std::make_index_sequence<FieldCount>{});
+        }
+
+        void Set(Entity entity, const T& value)
+        {
+            Store(m_entities.index(entity), value, std::make_index_sequence<FieldCount>{});
+        }
+
+        size_t Size() const
+        {
+            return m_entities.size();
+        }
+
+        /// @brief Size rounded up to a multiple of Lanes, streams are readable and writable up to this size
+        size_t AlignedSize() const
+        {
+            return (Size() + Lanes - 1) / Lanes * Lanes;
+        }
+
+        bool Empty() const
+        {
+            return m_entities.empty();
+        }
+
+        /// @brief Entity mapping, element i of every stream belongs to Entities()[i]
+        const Entity* Entities() const
+        {
+            return m_entities.data();
+        }
+
+        size_t IndexOf(Entity entity) const
+        {
+            return m_entities.index(entity);
+        }
+
+        /// @brief The array of the Index-th member listed in SoAFields
+        template<size_t Index>
+        FieldType<Index>* Stream()
+        {
+            return std::get<Index>(m_arrays).Data();
+        }
+
+        template<size_t Index>
+        const FieldType<Index>* Stream() const
+        {
+            return std::get<Index>(m_arrays).Data();
+        }
+
+        /// @brief The array of a member listed in SoAFields, e.g. StreamOf<&Position::x>()
+        template<auto Member>
+        auto* StreamOf()
+        {
+            return Stream<FieldIndex<Member>()>();
+        }
+
+        template<auto Member>
+        const auto* StreamOf() const
+        {
+            return Stream<FieldIndex<Member>()>();
+        }
+
+    private:
+        template<auto Member, size_t Index = 0>
+        static constexpr size_t FieldIndex()
+        {
+            if constexpr (Index == FieldCount)
+            {
+                static_assert(Index < FieldCount, "The member is not listed in SoAFields");
+                return Index;
+            }
+            else
+            {
+                constexpr auto candidate = std::get<Index>(Traits::Members);
+                if constexpr (eastl::is_same_v<eastl::remove_cv_t<decltype(candidate)>, decltype(Member)>)
+                {
+                    if constexpr (candidate == Member)
+                    {
+                        return Index;
+                    }
+                    else
+                    {
+                        return FieldIndex<Member, Index + 1>();
+                    }
+                }
+                else
+                {
+                    return FieldIndex<Member, Index + 1>();
+                }
+            }
+        }
+
+        template<size_t... Index>
+        void Store(size_t index, const T& value, std::index_sequence<Index...>)
+        {
+            ((Stream<Index>()[index] = value.*std::get<Index>(Traits::Members)), ...);
+        }
+
+        template<size_t... Index>
+        T Load(size_t index, std::index_sequence<Index...>) const
+        {
+            T value {};
+            ((value.*std::get<Index>(Traits::Members) = Stream<Index>()[index]), ...);
+            return value;
+        }
+
+        template<size_t... Index>
+        void Move(size_t from, size_t to, std::index_sequence<Index...>)
+        {
+            ((Stream<Index>()[to] = Stream<Index>()[from]), ...);
+        }
+
+        template<size_t... Index>
+        void Swap(size_t lhs, size_t rhs, std::index_sequence<Index...>)
+        {
+            (eastl::swap(Stream<Index>()[lhs], Stream<Index>()[rhs]), ...);
+        }
+
+        entt::basic_sparse_set<Entity> m_entities {entt::deletion_policy::swap_and_pop};
+        Arrays                         m_arrays;
+        size_t                         m_capacity {0};
+    };
+}
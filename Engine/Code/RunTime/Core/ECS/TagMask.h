@@ -0,0 +1,264 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPARK_TAGMASK_SSE2 1
+#endif
+
+#include <EASTL/vector.h>
+#include <EASTL/type_traits.h>
+#include <EASTL/algorithm.h>
+
+#include <entt/entt.hpp>
+
+#include "Entity.h"
+
+namespace Spark
+{
+    /// @brief Specialize for an empty tag component to mirror it in the per-entity tag bitmask of WorldContext:
+    ///  template<> struct TagTraits<SelectTag> : BitmaskTag {};
+    ///  The tag is still stored by entt, so views, Include and Exclude keep working, while Has and TagFilter
+    ///  read the bitmask instead of probing the tag storage.
+    template<typename T>
+    struct TagTraits
+    {
+        static constexpr bool Enabled = false;
+    };
+
+    struct BitmaskTag
+    {
+        static constexpr bool Enabled = true;
+    };
+
+    template<typename T>
+    inline constexpr bool IsBitmaskTag = TagTraits<T>::Enabled;
+
+    /// Maximum number of tag types declared by TagTraits in the process
+    inline constexpr uint32_t MaxBitmaskTags = 128;
+
+    inline uint32_t NextTagBit()
+    {
+        static std::atomic<uint32_t> s_next {0};
+        return s_next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// @brief Bit of a tag type in TagMask, assigned on first use and shared by all contexts
+    template<typename T>
+    uint32_t GetTagBit()
+    {
+        static_assert(IsBitmaskTag<T>, "TagTraits is not specialized for the tag");
+        static_assert(eastl::is_empty_v<T>, "Only empty components can be bitmask tags");
+
+        static const uint32_t s_bit = NextTagBit();
+        assert(s_bit < MaxBitmaskTags && "Too many bitmask tags");
+        return s_bit;
+    }
+
+    struct alignas(16) TagMask
+    {
+        static constexpr uint32_t WordBits = 64;
+        static constexpr uint32_t WordCount = MaxBitmaskTags / WordBits;
+
+        static_assert(WordCount == 2, "TagMask is handled as one 128-bit vector");
+
+        uint64_t m_words[WordCount] {};
+
+        void Set(uint32_t bit)
+        {
+            m_words[bit / WordBits] |= uint64_t(1) << (bit % WordBits);
+        }
+
+        void Reset(uint32_t bit)
+        {
+            m_words[bit / WordBits] &= ~(uint64_t(1) << (bit % WordBits));
+        }
+
+        bool Test(uint32_t bit) const
+        {
+            return (m_words[bit / WordBits] >> (bit % WordBits)) & 1;
+        }
+
+        bool Empty() const
+        {
+            return (m_words[0] | m_words[1]) == 0;
+        }
+
+        /// @brief Whether all the bits of include are set and none of exclude
+        bool Matches(const TagMask& include, const TagMask& exclude) const
+        {
+            return ((m_words[0] & include.m_words[0]) == include.m_words[0]) &&
+                   ((m_words[1] & include.m_words[1]) == include.m_words[1]) &&
+                   ((m_words[0] & exclude.m_words[0]) | (m_words[1] & exclude.m_words[1])) == 0;
+        }
+    };
+
+    template<typename... T>
+    TagMask MakeTagMask()
+    {
+        TagMask mask;
+        (mask.Set(GetTagBit<T>()), ...);
+        return mask;
+    }
+
+    /// @brief Entities with all the included tags and none of the excluded ones, built from the Include and
+    ///  Exclude helpers: TagFilter(Include<ActiveTag>, Exclude<DeadTag>)
+    struct TagFilter
+    {
+        TagFilter() = default;
+
+        template<typename... In, typename... Out>
+        TagFilter(entt::get_t<In...>, entt::exclude_t<Out...> = entt::exclude_t{})
+            : m_include(MakeTagMask<In...>()), m_exclude(MakeTagMask<Out...>())
+        {
+        }
+
+        template<typename... Out>
+        TagFilter(entt::exclude_t<Out...>) : m_exclude(MakeTagMask<Out...>())
+        {
+        }
+
+        TagMask m_include;
+        TagMask m_exclude;
+    };
+
+    /// @brief The tag bitmask of every entity, indexed by the entity index.
+    ///
+    /// The masks are updated by the construct and destroy signals of the registered tags, so they stay in sync
+    /// whichever way a tag is added. ForEach scans the packed mask array, 16 bytes per entity, with SSE2.
+    class TagMaskStorage
+    {
+    public:
+        TagMaskStorage() = default;
+
+        TagMaskStorage(const TagMaskStorage&) = delete;
+        TagMaskStorage& operator=(const TagMaskStorage&) = delete;
+
+        template<typename T>
+        bool IsRegistered() const
+        {
+            return m_registered.Test(GetTagBit<T>());
+        }
+
+        /// @brief Connect to the signals of the tag storage and import the entities which already have the tag
+        template<typename T>
+        void Register(entt::registry& registry)
+        {
+            const uint32_t bit = GetTagBit<T>();
+            if (m_registered.Test(bit))
+            {
+                return;
+            }
+            m_registered.Set(bit);
+
+            for (Entity entity : registry.view<T>())
+            {
+                OnConstruct<T>(registry, entity);
+            }
+            registry.on_construct<T>().template connect<&TagMaskStorage::OnConstruct<T>>(*this);
+            registry.on_destroy<T>().template connect<&TagMaskStorage::OnDestory<T>>(*this);
+        }
+
+        template<typename T>
+        void OnConstruct([[maybe_unused]] entt::registry& registry, Entity entity)
+        {
+            const size_t index = ToIndex(entity);
+            if (index >= m_masks.size())
+            {
+                const size_t size = eastl::max(index + 1, m_masks.size() * 2);
+                m_masks.resize(size);
+                m_entities.resize(size, NullEntity);
+            }
+
+            // 槽位属于已销毁的实体时先清空
+            if (m_entities[index] != entity)
+            {
+                m_entities[index] = entity;
+                m_masks[index] = TagMask{};
+            }
+            m_masks[index].Set(GetTagBit<T>());
+        }
+
+        template<typename T>
+        void OnDestory([[maybe_unused]] entt::registry& registry, Entity entity)
+        {
+            const size_t index = ToIndex(entity);
+            if (index >= m_masks.size() || m_entities[index] != entity)
+            {
+                return;
+            }
+
+            TagMask& mask = m_masks[index];
+            mask.Reset(GetTagBit<T>());
+            if (mask.Empty())
+            {
+                m_entities[index] = NullEntity;
+            }
+        }
+
+        /// @return An empty mask if the entity has no registered tag
+        TagMask Get(Entity entity) const
+        {
+            const size_t index = ToIndex(entity);
+            return index < m_masks.size() && m_entities[index] == entity ? m_masks[index] : TagMask{};
+        }
+
+        bool Test(Entity entity, uint32_t bit) const
+        {
+            const size_t index = ToIndex(entity);
+            return index < m_masks.size() && m_entities[index] == entity && m_masks[index].Test(bit);
+        }
+
+        /// @brief Call func(Entity) for the entities matching the filter, the filter must include at least one tag
+        template<typename Func>
+        void ForEach(const TagFilter& filter, Func&& func) const
+        {
+            assert(!filter.m_include.Empty() && "TagMaskStorage::ForEach needs an included tag");
+
+            const size_t size = m_masks.size();
+            const TagMask* masks = m_masks.data();
+#if defined(SPARK_TAGMASK_SSE2)
+            const __m128i include = _mm_loadu_si128(reinterpret_cast<const __m128i*>(filter.m_include.m_words));
+            const __m128i exclude = _mm_loadu_si128(reinterpret_cast<const __m128i*>(filter.m_exclude.m_words));
+            const __m128i zero = _mm_setzero_si128();
+            for (size_t index = 0; index < size; ++index)
+            {
+                // (mask & include) == include 且 (mask & exclude) == 0
+                const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks[index].m_words));
+                const __m128i hasAll = _mm_cmpeq_epi32(_mm_and_si128(mask, include), include);
+                const __m128i hasNone = _mm_cmpeq_epi32(_mm_and_si128(mask, exclude), zero);
+                if (_mm_movemask_epi8(_mm_and_si128(hasAll, hasNone)) == 0xFFFF)
+                {
+                    func(m_entities[index]);
+                }
+            }
+#else
+            for (size_t index = 0; index < size; ++index)
+            {
+                if (masks[index].Matches(filter.m_include, filter.m_exclude))
+                {
+                    func(m_entities[index]);
+                }
+            }
+#endif
+        }
+
+        void Clear()
+        {
+            m_masks.clear();
+            m_entities.clear();
+        }
+
+    private:
+        static size_t ToIndex(Entity entity)
+        {
+            return static_cast<size_t>(entt::to_entity(entity));
+        }
+
+        TagMask                m_registered;
+        eastl::vector<TagMask> m_masks;
+        eastl::vector<Entity>  m_entities;
+    };
+}
@@ -0,0 +1,96 @@
+#include "EntityReaper.h"
+
+#include <EASTL/algorithm.h>
+
+#include <Service/Service.h>
+#include <SceneManager/IScene.h>
+#include <CoreComponents/Tags.h>
+
+namespace Spark
+{
+    void EntityReaper::Initialize()
+    {
+        TickBus::Handler::BusConnect();
+    }
+
+    void EntityReaper::ShutDown()
+    {
+        TickBus::Handler::BusDisconnect();
+
+        m_queue.clear();
+        m_queueHead = 0;
+        m_queued.Clear();
+    }
+
+    void EntityReaper::OnTick(WorldContext& context, float deltaTime)
+    {
+        IScene* scene = Service<IScene>::Get();
+
+        auto view = context.GetView<DeadTag>();
+        for (Entity entity : view)
+        {
+            if (m_queued.Contains(entity))
+            {
+                continue;
+            }
+
+            if (m_config.m_destroySubtree && scene && scene->Contain(entity))
+            {
+                // 逆DFS序入队，子节点先于父节点销毁
+                auto subtree = scene->GetSubtreeView(entity);
+                for (auto it = subtree.rbegin(); it != subtree.rend(); ++it)
+                {
+                    Enqueue(it->first);
+                }
+            }
+            else
+            {
+                Enqueue(entity);
+            }
+        }
+
+        size_t count = GetPendingCount();
+        if (m_config.m_maxDestroyPerTick > 0)
+        {
+            count = eastl::min<size_t>(count, m_config.m_maxDestroyPerTick);
+        }
+        if (count == 0)
+        {
+            return;
+        }
+
+        Entity* first = m_queue.begin() + m_queueHead;
+        Entity* last = first + count;
+        for (Entity* cur = first; cur != last; ++cur)
+        {
+            m_queued.Erase(*cur);
+        }
+        // 实体可能已被其他地方销毁
+        last = eastl::remove_if(first, last, [&context](Entity entity) { return !context.Valid(entity); });
+
+        {
+            SceneBatchScope batch(scene);
+            context.DestoryEntity(first, last);
+        }
+
+        m_queueHead += count;
+        if (m_queueHead == m_queue.size())
+        {
+            m_queue.clear();
+            m_queueHead = 0;
+        }
+        else if (m_queueHead * 2 > m_queue.size())
+        {
+            m_queue.erase(m_queue.begin(), m_queue.begin() + m_queueHead);
+            m_queueHead = 0;
+        }
+    }
+
+    void EntityReaper::Enqueue(Entity entity)
+    {
+        if (m_queued.Insert(entity).second)
+        {
+            m_queue.push_back(entity);
+        }
+    }
+}
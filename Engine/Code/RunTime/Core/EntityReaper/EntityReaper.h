@@ -1,25 +1,37 @@
 #pragma once
 
+#include <EASTL/vector.h>
+
 #include <ECS/ISystem.h>
+#include <ECS/EntityMap.h>
 #include <Tick/TickBus.h>
-#include <CoreComponents/Tags.h>
 
 namespace Spark
 {
+    struct EntityReaperConfig
+    {
+        /// Destroy all descendants in the scene together with an entity marked by DeadTag
+        bool m_destroySubtree = false;
+
+        /// Max number of entities destroyed in one tick, the rest are destroyed in the following ticks. 0 means no limit.
+        uint32_t m_maxDestroyPerTick = 0;
+    };
+
+    /// @brief Destroy entities marked by DeadTag at the end of every tick.
+    ///
+    /// Dead entities are queued and destroyed inside one scene batch per tick, so the scene hierarchy is only
+    /// fixed up once. In subtree mode the descendants are queued before their ancestors (reverse DFS order),
+    /// so no child has to be re-linked to its grandparent.
     class EntityReaper final : public ISystem,
                                public TickBus::Handler
     {
     public:
-        // ISystem
-        void Initialize() override
-        {
-            TickBus::Handler::BusConnect();
-        }
+        EntityReaper() = default;
+        explicit EntityReaper(const EntityReaperConfig& config) : m_config(config) {}
 
-        void ShutDown() override
-        {
-            TickBus::Handler::BusDisconnect();
-        }
+        // ISystem
+        void Initialize() override;
+        void ShutDown() override;
 
         eastl::vector<HashString> Request() const override
         {
@@ -32,16 +44,37 @@ namespace Spark
         }
 
         // TickBus
-        void OnTick(WorldContext& context, float deltaTime) override
+        void OnTick(WorldContext& context, float deltaTime) override;
+
+        unsigned int GetTickOrder() const override
         {
-            auto view = context.GetView<DeadTag>();
-            context.DestoryEntity(view.begin(), view.end());
+            return static_cast<unsigned int>(TickOrder::TICK_LAST);
         }
 
-        unsigned int GetTickOrder() const
+        void SetConfig(const EntityReaperConfig& config)
         {
-            return static_cast<unsigned int>(TickOrder::TICK_LAST);
+            m_config = config;
+        }
+
+        const EntityReaperConfig& GetConfig() const
+        {
+            return m_config;
         }
 
+        /// @brief Number of entities waiting to be destroyed in the following ticks
+        size_t GetPendingCount() const
+        {
+            return m_queue.size() - m_queueHead;
+        }
+
+    private:
+        void Enqueue(Entity entity);
+
+        EntityReaperConfig m_config {};
+
+        // m_queue[m_queueHead, end) 为待销毁实体，m_queued用于去重
+        eastl::vector<Entity> m_queue;
+        size_t                m_queueHead {0};
+        EntitySet             m_queued;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <EASTL/vector.h>
+#include <EASTL/type_traits.h>
+#include <EASTL/memory.h>
+
+#include "Job.h"
+
+namespace Spark
+{
+    struct JobWorkerStats
+    {
+        uint64_t m_executedJobs = 0;
+        uint64_t m_stolenJobs = 0;
+        double   m_busySeconds = 0.0;
+        double   m_idleSeconds = 0.0;
+
+        /// Busy time / (busy time + idle time) since the last reset
+        float    m_utilization = 0.f;
+    };
+
+    /**
+    *  任务系统接口，通过Service<IJobSystem>获取
+    */
+    class IJobSystem
+    {
+    public:
+        virtual ~IJobSystem() = default;
+
+        /// @brief Create a job without submitting it, dependencies can be added before Submit
+        virtual JobHandle CreateJob(JobFunc func) = 0;
+
+        /// @brief The job will not start before dependency has finished, must be called before the job is submitted
+        virtual void AddDependency(const JobHandle& job, const JobHandle& dependency) = 0;
+
+        /// @brief Queue the job once all its dependencies have finished
+        virtual void Submit(const JobHandle& job) = 0;
+
+        /// @brief Wait until the job has finished, the calling thread runs other queued jobs meanwhile
+        virtual void Wait(const JobHandle& job) = 0;
+
+        /// @brief Number of worker threads, the thread calling Wait or ParallelFor also runs jobs
+        virtual size_t GetWorkerCount() const = 0;
+
+        virtual eastl::vector<JobWorkerStats> GetWorkerStats() const = 0;
+
+        virtual void ResetWorkerStats() = 0;
+
+        JobHandle Schedule(JobFunc func)
+        {
+            JobHandle job = CreateJob(eastl::move(func));
+            Submit(job);
+            return job;
+        }
+
+        /// @brief Schedule a continuation which runs after dependency has finished
+        JobHandle Then(const JobHandle& dependency, JobFunc func)
+        {
+            JobHandle job = CreateJob(eastl::move(func));
+            AddDependency(job, dependency);
+            Submit(job);
+            return job;
+        }
+
+        /// @brief Call func on sub ranges of [begin, end) concurrently and wait for all of them.
+        ///  The range is split lazily: a part is only split off when there is an idle thread to take it,
+        ///  so the number of calls adapts to the load. Every call gets at least minGrain elements
+        ///  (except the last one of a range).
+        /// @param func void(size_t first, size_t last), must be thread safe
+        template<typename Func>
+        void ParallelFor(size_t begin, size_t end, Func&& func, size_t minGrain = 1)
+        {
+            if (begin >= end)
+            {
+                return;
+            }
+
+            using FuncType = eastl::remove_reference_t<Func>;
+            auto invoke = [](void* userData, size_t first, size_t last)
+            {
+                (*static_cast<FuncType*>(userData))(first, last);
+            };
+            ParallelForImpl(begin, end, minGrain, invoke,
+                            const_cast<void*>(static_cast<const void*>(eastl::addressof(func))));
+        }
+
+    protected:
+        using RangeFunc = void (*)(void*, size_t, size_t);
+
+        virtual void ParallelForImpl(size_t begin, size_t end, size_t minGrain, RangeFunc func, void* userData) = 0;
+    };
+}
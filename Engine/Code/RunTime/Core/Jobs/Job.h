@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+
+#include <EASTL/vector.h>
+#include <EASTL/functional.h>
+#include <EASTL/intrusive_ptr.h>
+
+namespace Spark
+{
+    using JobFunc = eastl::function<void()>;
+
+    class JobSystem;
+
+    /// @brief A unit of work of IJobSystem, referenced by JobHandle.
+    ///
+    /// A job is created unsubmitted, dependencies can only be added before it is submitted.
+    /// It is queued once it has been submitted and all its dependencies have finished.
+    class Job final
+    {
+    public:
+        Job() = default;
+        explicit Job(JobFunc func) : m_func(eastl::move(func)) {}
+
+        Job(const Job&) = delete;
+        Job& operator=(const Job&) = delete;
+
+        bool IsFinished() const
+        {
+            return m_finished.load(std::memory_order_acquire);
+        }
+
+        void AddRef()
+        {
+            m_refCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void Release()
+        {
+            if (m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                delete this;
+            }
+        }
+
+    private:
+        friend class JobSystem;
+
+        using RangeFunc = void (*)(void*, size_t, size_t);
+
+        // ParallelFor的分块任务
+        struct RangeTask
+        {
+            RangeFunc           func {nullptr};
+            void*               userData {nullptr};
+            size_t              grain {1};
+            std::atomic<size_t> remaining {0};
+        };
+
+        void Lock()
+        {
+            while (m_lock.test_and_set(std::memory_order_acquire))
+            {
+            }
+        }
+
+        void Unlock()
+        {
+            m_lock.clear(std::memory_order_release);
+        }
+
+        JobFunc               m_func;
+        RangeTask*            m_range {nullptr};
+        size_t                m_begin {0};
+        size_t                m_end {0};
+
+        std::atomic<uint32_t> m_refCount {0};
+        // 未完成的依赖数量，提交前额外持有1
+        std::atomic<uint32_t> m_dependencies {1};
+        std::atomic<bool>     m_finished {false};
+
+        // 以下成员由m_lock保护，后续任务各持有一个引用
+        std::atomic_flag      m_lock = ATOMIC_FLAG_INIT;
+        eastl::vector<Job*>   m_continuations;
+    };
+
+    using JobHandle = eastl::intrusive_ptr<Job>;
+}
@@ -0,0 +1,424 @@
+#include "JobSystem.h"
+
+#include <chrono>
+
+#include <EASTL/algorithm.h>
+
+namespace Spark
+{
+    namespace
+    {
+        thread_local void* t_currentWorker = nullptr;
+
+        // 找不到任务时在休眠前重试的次数
+        constexpr uint32_t SpinCount = 64;
+
+        uint64_t NowNanoseconds()
+        {
+            using namespace std::chrono;
+            return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+        }
+
+        uint32_t NextRandom(uint32_t& seed)
+        {
+            // xorshift32
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            return seed;
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        ShutDown();
+    }
+
+    void JobSystem::Initialize()
+    {
+        if (!m_workers.empty())
+        {
+            return;
+        }
+
+        uint32_t workerCount = m_config.m_workerCount;
+        if (workerCount == 0)
+        {
+            workerCount = eastl::max<uint32_t>(std::thread::hardware_concurrency(), 2) - 1;
+        }
+
+        m_quit.store(false);
+        m_workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            auto worker = eastl::make_unique<Worker>();
+            worker->owner = this;
+            worker->index = i;
+            worker->seed = i * 2654435761u + 1u;
+            m_workers.push_back(eastl::move(worker));
+        }
+
+        // 所有worker创建完成后再启动线程，窃取时会遍历m_workers
+        for (auto& worker : m_workers)
+        {
+            Worker* current = worker.get();
+            current->thread = std::thread([this, current]() { WorkerLoop(*current); });
+        }
+    }
+
+    void JobSystem::ShutDown()
+    {
+        if (m_workers.empty())
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_quit.store(true);
+        }
+        m_wakeCondition.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            worker->thread.join();
+        }
+
+        // 未执行的任务直接丢弃
+        Job* job = nullptr;
+        for (auto& worker : m_workers)
+        {
+            while (worker->deque.Pop(job))
+            {
+                job->Release();
+            }
+        }
+        m_workers.clear();
+
+        std::lock_guard<std::mutex> lock(m_injectionMutex);
+        for (Job* pending : m_injection)
+        {
+            pending->Release();
+        }
+        m_injection.clear();
+        m_injectionSize.store(0);
+        m_queuedJobs.store(0);
+    }
+
+    JobHandle JobSystem::CreateJob(JobFunc func)
+    {
+        return JobHandle(new Job(eastl::move(func)));
+    }
+
+    void JobSystem::AddDependency(const JobHandle& job, const JobHandle& dependency)
+    {
+        if (!job || !dependency || job == dependency)
+        {
+            return;
+        }
+
+        dependency->Lock();
+        if (!dependency->m_finished.load(std::memory_order_relaxed))
+        {
+            job->m_dependencies.fetch_add(1, std::memory_order_relaxed);
+            job->AddRef();
+            dependency->m_continuations.push_back(job.get());
+        }
+        dependency->Unlock();
+    }
+
+    void JobSystem::Submit(const JobHandle& job)
+    {
+        if (!job)
+        {
+            return;
+        }
+
+        job->AddRef();
+        if (job->m_dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            Enqueue(job.get());
+        }
+        else
+        {
+            // 由最后完成的依赖任务入队
+            job->Release();
+        }
+    }
+
+    void JobSystem::Wait(const JobHandle& job)
+    {
+        if (!job)
+        {
+            return;
+        }
+
+        while (!job->IsFinished())
+        {
+            if (!RunOneJob())
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    eastl::vector<JobWorkerStats> JobSystem::GetWorkerStats() const
+    {
+        eastl::vector<JobWorkerStats> result;
+        result.reserve(m_workers.size());
+        for (const auto& worker : m_workers)
+        {
+            JobWorkerStats stats;
+            stats.m_executedJobs = worker->executedJobs.load(std::memory_order_relaxed);
+            stats.m_stolenJobs = worker->stolenJobs.load(std::memory_order_relaxed);
+            const uint64_t busy = worker->busyNanoseconds.load(std::memory_order_relaxed);
+            const uint64_t idle = worker->idleNanoseconds.load(std::memory_order_relaxed);
+            stats.m_busySeconds = busy * 1e-9;
+            stats.m_idleSeconds = idle * 1e-9;
+            stats.m_utilization = busy + idle > 0 ? static_cast<float>(double(busy) / double(busy + idle)) : 0.f;
+            result.push_back(stats);
+        }
+        return result;
+    }
+
+    void JobSystem::ResetWorkerStats()
+    {
+        for (auto& worker : m_workers)
+        {
+            worker->executedJobs.store(0, std::memory_order_relaxed);
+            worker->stolenJobs.store(0, std::memory_order_relaxed);
+            worker->busyNanoseconds.store(0, std::memory_order_relaxed);
+            worker->idleNanoseconds.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    JobSystem::Worker* JobSystem::GetCurrentWorker() const
+    {
+        Worker* worker = static_cast<Worker*>(t_currentWorker);
+        return worker && worker->owner == this ? worker : nullptr;
+    }
+
+    void JobSystem::WorkerLoop(Worker& worker)
+    {
+        t_currentWorker = &worker;
+
+        uint32_t spin = 0;
+        while (!m_quit.load(std::memory_order_relaxed))
+        {
+            if (Job* job = FindJob(&worker))
+            {
+                spin = 0;
+                const uint64_t start = NowNanoseconds();
+                Execute(job, &worker);
+                worker.busyNanoseconds.fetch_add(NowNanoseconds() - start, std::memory_order_relaxed);
+                continue;
+            }
+
+            const uint64_t start = NowNanoseconds();
+            if (++spin < SpinCount)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                spin = 0;
+                std::unique_lock<std::mutex> lock(m_sleepMutex);
+                m_sleepingWorkers.fetch_add(1);
+                m_wakeCondition.wait(lock, [this]() { return m_quit.load() || m_queuedJobs.load() > 0; });
+                m_sleepingWorkers.fetch_sub(1);
+            }
+            worker.idleNanoseconds.fetch_add(NowNanoseconds() - start, std::memory_order_relaxed);
+        }
+
+        t_currentWorker = nullptr;
+    }
+
+    void JobSystem::Enqueue(Job* job)
+    {
+        if (m_workers.empty())
+        {
+            // 没有worker时在调用线程执行
+            Execute(job, nullptr);
+            return;
+        }
+
+        m_queuedJobs.fetch_add(1);
+        if (Worker* worker = GetCurrentWorker())
+        {
+            worker->deque.Push(job);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(m_injectionMutex);
+            m_injection.push_back(job);
+            m_injectionSize.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (m_sleepingWorkers.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_wakeCondition.notify_one();
+        }
+    }
+
+    Job* JobSystem::FindJob(Worker* worker)
+    {
+        Job* job = nullptr;
+        if (worker && worker->deque.Pop(job))
+        {
+            m_queuedJobs.fetch_sub(1);
+            return job;
+        }
+
+        if (m_injectionSize.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_injectionMutex);
+            if (!m_injection.empty())
+            {
+                job = m_injection.front();
+                m_injection.pop_front();
+                m_injectionSize.fetch_sub(1, std::memory_order_relaxed);
+                m_queuedJobs.fetch_sub(1);
+                return job;
+            }
+        }
+
+        // 从随机位置开始尝试窃取
+        const size_t count = m_workers.size();
+        thread_local uint32_t t_seed = 0x9e3779b9u;
+        uint32_t& seed = worker ? worker->seed : t_seed;
+        const size_t first = NextRandom(seed) % count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Worker* victim = m_workers[(first + i) % count].get();
+            if (victim != worker && victim->deque.Steal(job))
+            {
+                m_queuedJobs.fetch_sub(1);
+                if (worker)
+                {
+                    worker->stolenJobs.fetch_add(1, std::memory_order_relaxed);
+                }
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool JobSystem::RunOneJob()
+    {
+        Worker* worker = GetCurrentWorker();
+        Job* job = FindJob(worker);
+        if (!job)
+        {
+            return false;
+        }
+
+        Execute(job, worker);
+        return true;
+    }
+
+    void JobSystem::Execute(Job* job, Worker* worker)
+    {
+        if (job->m_range)
+        {
+            RunRange(*job->m_range, job->m_begin, job->m_end);
+        }
+        else if (job->m_func)
+        {
+            job->m_func();
+        }
+
+        if (worker)
+        {
+            worker->executedJobs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Finish(job);
+        job->Release();
+    }
+
+    void JobSystem::Finish(Job* job)
+    {
+        eastl::vector<Job*> continuations;
+        job->Lock();
+        job->m_finished.store(true, std::memory_order_release);
+        continuations.swap(job->m_continuations);
+        job->Unlock();
+
+        for (Job* continuation : continuations)
+        {
+            // 后续任务持有的引用交给队列
+            if (continuation->m_dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                Enqueue(continuation);
+            }
+            else
+            {
+                continuation->Release();
+            }
+        }
+    }
+
+    void JobSystem::ParallelForImpl(size_t begin, size_t end, size_t minGrain, RangeFunc func, void* userData)
+    {
+        const size_t count = end - begin;
+        const size_t threadCount = m_workers.size() + 1;
+
+        // 每个线程至少分到若干块以便负载均衡，同时限制调用次数
+        Job::RangeTask task;
+        task.func = func;
+        task.userData = userData;
+        task.grain = eastl::max<size_t>(eastl::max<size_t>(minGrain, 1), count / (threadCount * 16));
+        task.remaining.store(count, std::memory_order_relaxed);
+
+        if (m_workers.empty() || count <= task.grain)
+        {
+            func(userData, begin, end);
+            return;
+        }
+
+        RunRange(task, begin, end);
+        while (task.remaining.load(std::memory_order_acquire) > 0)
+        {
+            if (!RunOneJob())
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::RunRange(Job::RangeTask& task, size_t begin, size_t end)
+    {
+        // 每处理一块检查一次是否需要拆分剩余部分
+        while (begin < end)
+        {
+            while (end - begin > task.grain * 2 && ShouldSplit())
+            {
+                const size_t middle = begin + (end - begin) / 2;
+                Job* job = new Job();
+                job->m_range = &task;
+                job->m_begin = middle;
+                job->m_end = end;
+                job->AddRef();
+                Enqueue(job);
+                end = middle;
+            }
+
+            const size_t last = eastl::min(end, begin + task.grain);
+            task.func(task.userData, begin, last);
+            task.remaining.fetch_sub(last - begin, std::memory_order_acq_rel);
+            begin = last;
+        }
+    }
+
+    bool JobSystem::ShouldSplit() const
+    {
+        // 上次拆分出的任务已被其他线程取走时才继续拆分
+        if (Worker* worker = GetCurrentWorker())
+        {
+            return worker->deque.Empty();
+        }
+        return m_injectionSize.load(std::memory_order_relaxed) == 0;
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include <EASTL/vector.h>
+#include <EASTL/deque.h>
+#include <EASTL/unique_ptr.h>
+
+#include <ECS/ISystem.h>
+#include <Service/Service.h>
+
+#include "IJobSystem.h"
+#include "WorkStealingDeque.h"
+
+namespace Spark
+{
+    struct JobSystemConfig
+    {
+        /// Number of worker threads, 0 means one less than the hardware threads
+        uint32_t m_workerCount = 0;
+    };
+
+    /// @brief Work stealing job system.
+    ///
+    /// Every worker owns a Chase-Lev deque: jobs queued by a worker go to its own deque and are popped LIFO,
+    /// idle workers steal FIFO from the others. Jobs queued by other threads go to a shared injection queue.
+    /// Workers which find nothing sleep until a job is queued.
+    class JobSystem final : public ISystem,
+                            public Service<IJobSystem>::Handler
+    {
+    public:
+        JobSystem() = default;
+        explicit JobSystem(const JobSystemConfig& config) : m_config(config) {}
+        ~JobSystem();
+
+        // ISystem
+        void Initialize() override;
+        void ShutDown() override;
+        eastl::vector<HashString> Request() const override
+        {
+            return {};
+        }
+
+        HashString GetName() const override
+        {
+            return "JobSystem"_hs;
+        }
+
+        // IJobSystem
+        JobHandle CreateJob(JobFunc func) override;
+        void AddDependency(const JobHandle& job, const JobHandle& dependency) override;
+        void Submit(const JobHandle& job) override;
+        void Wait(const JobHandle& job) override;
+
+        size_t GetWorkerCount() const override
+        {
+            return m_workers.size();
+        }
+
+        eastl::vector<JobWorkerStats> GetWorkerStats() const override;
+        void ResetWorkerStats() override;
+
+    protected:
+        void ParallelForImpl(size_t begin, size_t end, size_t minGrain, RangeFunc func, void* userData) override;
+
+    private:
+        struct Worker
+        {
+            JobSystem*              owner {nullptr};
+            uint32_t                index {0};
+            uint32_t                seed {0};
+            WorkStealingDeque<Job*> deque;
+            std::thread             thread;
+
+            // 统计数据，只由该worker写入
+            alignas(64) std::atomic<uint64_t> executedJobs {0};
+            std::atomic<uint64_t>             stolenJobs {0};
+            std::atomic<uint64_t>             busyNanoseconds {0};
+            std::atomic<uint64_t>             idleNanoseconds {0};
+        };
+
+        /// @brief The worker of this system running on the calling thread, nullptr on other threads
+        Worker* GetCurrentWorker() const;
+
+        void WorkerLoop(Worker& worker);
+
+        /// @brief Queue a job, the queue takes over one reference of the job
+        void Enqueue(Job* job);
+
+        /// @brief Take a queued job, the caller owns one reference of the returned job
+        Job* FindJob(Worker* worker);
+
+        /// @brief Run one queued job on the calling thread
+        /// @return false if there is no queued job
+        bool RunOneJob();
+
+        void Execute(Job* job, Worker* worker);
+
+        /// @brief Mark the job finished and queue the continuations which are ready
+        void Finish(Job* job);
+
+        /// @brief Process [begin, end) of a ParallelFor, splitting off the upper half while another thread can take it
+        void RunRange(Job::RangeTask& task, size_t begin, size_t end);
+
+        bool ShouldSplit() const;
+
+        JobSystemConfig m_config {};
+
+        eastl::vector<eastl::unique_ptr<Worker>> m_workers;
+
+        // 非worker线程提交的任务
+        std::mutex            m_injectionMutex;
+        eastl::deque<Job*>    m_injection;
+        std::atomic<size_t>   m_injectionSize {0};
+
+        // 已入队但尚未取出的任务数量，用于唤醒worker
+        std::atomic<size_t>     m_queuedJobs {0};
+        std::atomic<uint32_t>   m_sleepingWorkers {0};
+        std::mutex              m_sleepMutex;
+        std::condition_variable m_wakeCondition;
+        std::atomic<bool>       m_quit {false};
+    };
+}
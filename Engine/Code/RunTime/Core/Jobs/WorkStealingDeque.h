@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+
+#include <EASTL/vector.h>
+#include <EASTL/unique_ptr.h>
+#include <EASTL/type_traits.h>
+
+namespace Spark
+{
+    /// @brief Chase-Lev work stealing deque.
+    ///
+    /// The owner thread pushes and pops at the bottom, other threads steal from the top.
+    /// The buffer grows when it is full; old buffers are kept until the deque is destroyed,
+    /// because a thief may still read from them.
+    /// Memory orders follow "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013).
+    template<typename T>
+    class WorkStealingDeque
+    {
+        static_assert(eastl::is_trivially_copyable_v<T>, "WorkStealingDeque stores trivially copyable values");
+
+        class Buffer
+        {
+        public:
+            explicit Buffer(int64_t capacity)
+                : m_capacity(capacity), m_mask(capacity - 1), m_data(new std::atomic<T>[capacity])
+            {
+            }
+
+            int64_t Capacity() const
+            {
+                return m_capacity;
+            }
+
+            T Get(int64_t index) const
+            {
+                return m_data[index & m_mask].load(std::memory_order_relaxed);
+            }
+
+            void Put(int64_t index, T value)
+            {
+                m_data[index & m_mask].store(value, std::memory_order_relaxed);
+            }
+
+        private:
+            int64_t m_capacity;
+            int64_t m_mask;
+            eastl::unique_ptr<std::atomic<T>[]> m_data;
+        };
+
+    public:
+        /// @param capacity Initial capacity, must be a power of two
+        explicit WorkStealingDeque(int64_t capacity = 256)
+        {
+            m_buffers.emplace_back(new Buffer(capacity));
+            m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        /// @brief Owner only
+        void Push(T value)
+        {
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            const int64_t top = m_top.load(std::memory_order_acquire);
+            Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+            if (bottom - top > buffer->Capacity() - 1)
+            {
+                buffer = Grow(buffer, top, bottom);
+            }
+
+            buffer->Put(bottom, value);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        /// @brief Owner only
+        bool Pop(T& value)
+        {
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = m_top.load(std::memory_order_relaxed);
+
+            if (top > bottom)
+            {
+                // 已空
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            value = buffer->Get(bottom);
+            if (top == bottom)
+            {
+                // 最后一个元素，与窃取线程竞争
+                const bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                               std::memory_order_relaxed);
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /// @brief Any thread
+        bool Steal(T& value)
+        {
+            int64_t top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+            if (top >= bottom)
+            {
+                return false;
+            }
+
+            Buffer* buffer = m_buffer.load(std::memory_order_acquire);
+            T result = buffer->Get(top);
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return false;
+            }
+
+            value = result;
+            return true;
+        }
+
+        /// @brief Approximate number of elements
+        size_t Size() const
+        {
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            const int64_t top = m_top.load(std::memory_order_relaxed);
+            return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+        }
+
+        bool Empty() const
+        {
+            return Size() == 0;
+        }
+
+    private:
+        Buffer* Grow(Buffer* buffer, int64_t top, int64_t bottom)
+        {
+            Buffer* newBuffer = new Buffer(buffer->Capacity() * 2);
+            for (int64_t i = top; i < bottom; ++i)
+            {
+                newBuffer->Put(i, buffer->Get(i));
+            }
+            m_buffers.emplace_back(newBuffer);
+            m_buffer.store(newBuffer, std::memory_order_release);
+            return newBuffer;
+        }
+
+        alignas(64) std::atomic<int64_t> m_top {0};
+        alignas(64) std::atomic<int64_t> m_bottom {0};
+        std::atomic<Buffer*>             m_buffer {nullptr};
+
+        // 只由owner线程访问
+        eastl::vector<eastl::unique_ptr<Buffer>> m_buffers;
+    };
+}
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <mutex>
+#include <atomic>
+#include <type_traits>
+
+#include <EASTL/unordered_map.h>
+
 #include <entt/meta/meta.hpp>
 #include <entt/core/type_info.hpp>
 
@@ -30,4 +36,85 @@ namespace Spark
     static constexpr TypeId GetTypeId() {
         return entt::type_hash<T>::value();
     }
-}
\ No newline at end of file
+
+    /// Dense index of a type, see GetTypeIndex
+    using TypeIndex = uint32_t;
+
+    inline constexpr TypeIndex InvalidTypeIndex = ~TypeIndex(0);
+
+    namespace Internal
+    {
+        class TypeIndexRegistry
+        {
+        public:
+            /// @brief Thread safe, the same TypeId always gets the same index
+            static TypeIndex Register(TypeId typeId)
+            {
+                std::lock_guard<std::mutex> lock(GetMutex());
+                auto& indices = GetIndices();
+                auto it = indices.find(typeId);
+                if (it != indices.end())
+                {
+                    return it->second;
+                }
+                const TypeIndex index = GetCounter().fetch_add(1, std::memory_order_relaxed);
+                indices.emplace(typeId, index);
+                return index;
+            }
+
+            static TypeIndex Find(TypeId typeId)
+            {
+                std::lock_guard<std::mutex> lock(GetMutex());
+                const auto& indices = GetIndices();
+                auto it = indices.find(typeId);
+                return it != indices.end() ? it->second : InvalidTypeIndex;
+            }
+
+            static uint32_t GetCount()
+            {
+                return GetCounter().load(std::memory_order_relaxed);
+            }
+
+        private:
+            static std::mutex& GetMutex()
+            {
+                static std::mutex s_mutex;
+                return s_mutex;
+            }
+
+            static eastl::unordered_map<TypeId, TypeIndex>& GetIndices()
+            {
+                static eastl::unordered_map<TypeId, TypeIndex> s_indices;
+                return s_indices;
+            }
+
+            static std::atomic<uint32_t>& GetCounter()
+            {
+                static std::atomic<uint32_t> s_counter {0};
+                return s_counter;
+            }
+        };
+    }
+
+    /// @brief Process-wide dense index of a type, assigned in the order of first use: 0, 1, 2...
+    ///  Per-type tables can be flat arrays indexed by it instead of hash maps keyed by GetTypeId.
+    ///  Only the first call of each type takes a lock, later calls read a local static.
+    template<typename T>
+    TypeIndex GetTypeIndex()
+    {
+        static const TypeIndex s_index = Internal::TypeIndexRegistry::Register(GetTypeId<std::remove_cv_t<T>>());
+        return s_index;
+    }
+
+    /// @return InvalidTypeIndex if GetTypeIndex has not been called for the type yet
+    inline TypeIndex FindTypeIndex(TypeId typeId)
+    {
+        return Internal::TypeIndexRegistry::Find(typeId);
+    }
+
+    /// @brief Number of types which have an index, an upper bound of every index
+    inline uint32_t GetTypeIndexCount()
+    {
+        return Internal::TypeIndexRegistry::GetCount();
+    }
+}
@@ -0,0 +1,351 @@
+#pragma once
+
+#include <EASTL/vector.h>
+#include <EASTL/numeric_limits.h>
+
+#include <ECS/Entity.h>
+#include <ECS/EntityMap.h>
+
+namespace Spark
+{
+    /// @brief Keep the DFS (pre-order) sequence of a forest incrementally.
+    ///
+    /// Every entity owns two tokens in a doubly linked list, an enter token and an exit token,
+    /// all tokens between them belong to the entity's descendants. So a whole subtree is always
+    /// a contiguous range [enter, exit] and can be spliced in or out in O(1).
+    ///
+    /// The position of an entity is described in the same way as the Hierarchy component:
+    /// it is placed after its previous sibling if it has one, otherwise it is placed as the first
+    /// child of its parent, a root entity without parent is appended to the end of the sequence.
+    ///
+    /// Tokens also carry order labels which increase along the list (order-maintenance), so
+    /// "a is an ancestor of b" is the interval test enter(a) < enter(b) && exit(b) < exit(a).
+    /// Depth and root are cached on the enter token and updated for the moved subtree only.
+    class EntityDFSOrder
+    {
+        using Slot = uint32_t;
+        using Label = uint64_t;
+
+        // 哨兵节点，链表首尾相连
+        static constexpr Slot Sentinel = 0;
+
+        // 哨兵作为起点时标号为0，作为终点时标号为最大值
+        static constexpr Label MinLabel = 0;
+        static constexpr Label MaxLabel = eastl::numeric_limits<Label>::max();
+
+        // 标号块的密度阈值，取值在(1, 2)之间，越小重新标号越少但可容纳的节点越少
+        static constexpr double Density = 1.4;
+
+        struct Node
+        {
+            Slot   prev {Sentinel};
+            Slot   next {Sentinel};
+            Entity entity {NullEntity};
+            Label  label {MinLabel};
+            // 只在enter token上有效
+            uint32_t depth {0};
+            Entity   root {NullEntity};
+        };
+
+    public:
+        EntityDFSOrder()
+        {
+            // slot 0 为哨兵，slot 1 占位，保证 enter slot 为偶数，exit slot 为奇数
+            m_nodes.resize(2);
+        }
+
+        bool Contain(Entity entity) const
+        {
+            return m_enterSlots.Contains(entity);
+        }
+
+        size_t Size() const
+        {
+            return m_enterSlots.Size();
+        }
+
+        bool Empty() const
+        {
+            return m_enterSlots.Empty();
+        }
+
+        /// @brief Insert an entity without any descendant
+        /// @return false if the entity is already in the order
+        bool Insert(Entity entity, Entity parent, Entity prevSibling)
+        {
+            if (entity == NullEntity || Contain(entity))
+            {
+                return false;
+            }
+
+            Slot enter = AllocateSlots(entity);
+            Slot exit = enter + 1;
+            m_nodes[enter].next = exit;
+            m_nodes[exit].prev = enter;
+            Slot after = GetInsertPosition(parent, prevSibling);
+            Link(enter, exit, after);
+            AssignLabels(after, 2);
+
+            const Slot* parentSlot = m_enterSlots.Find(parent);
+            m_nodes[enter].depth = parentSlot ? m_nodes[*parentSlot].depth + 1 : 0;
+            m_nodes[enter].root = parentSlot ? m_nodes[*parentSlot].root : entity;
+            return true;
+        }
+
+        /// @brief Move an entity together with all its descendants to a new position
+        /// The new position must not be inside the subtree of the entity
+        bool Move(Entity entity, Entity parent, Entity prevSibling)
+        {
+            const Slot* slot = m_enterSlots.Find(entity);
+            if (!slot)
+            {
+                return false;
+            }
+
+            Slot enter = *slot;
+            Slot exit = enter + 1;
+            Unlink(enter, exit);
+            Slot after = GetInsertPosition(parent, prevSibling);
+            Link(enter, exit, after);
+
+            const Slot* parentSlot = m_enterSlots.Find(parent);
+            const uint32_t depth = parentSlot ? m_nodes[*parentSlot].depth + 1 : 0;
+            const Entity root = parentSlot ? m_nodes[*parentSlot].root : entity;
+            const int64_t delta = int64_t(depth) - int64_t(m_nodes[enter].depth);
+
+            // 整棵子树重新标号，并更新深度和根节点
+            uint32_t count = 0;
+            for (Slot cur = enter; ; cur = m_nodes[cur].next)
+            {
+                ++count;
+                if (!IsExit(cur))
+                {
+                    m_nodes[cur].depth = static_cast<uint32_t>(m_nodes[cur].depth + delta);
+                    m_nodes[cur].root = root;
+                }
+                if (cur == exit)
+                {
+                    break;
+                }
+            }
+            AssignLabels(after, count);
+            return true;
+        }
+
+        /// @brief Remove an entity, its descendants will take its place in the order
+        bool Remove(Entity entity)
+        {
+            const Slot* slot = m_enterSlots.Find(entity);
+            if (!slot)
+            {
+                return false;
+            }
+
+            Slot enter = *slot;
+            Slot exit = enter + 1;
+
+            // 后代节点上升一层，若被移除的是根节点，其子节点成为新的根
+            const bool isRoot = m_nodes[enter].depth == 0;
+            Entity root = m_nodes[enter].root;
+            for (Slot cur = m_nodes[enter].next; cur != exit; cur = m_nodes[cur].next)
+            {
+                if (IsExit(cur))
+                {
+                    continue;
+                }
+                if (isRoot && m_nodes[cur].depth == 1)
+                {
+                    root = m_nodes[cur].entity;
+                }
+                --m_nodes[cur].depth;
+                m_nodes[cur].root = root;
+            }
+
+            Unlink(enter, enter);
+            Unlink(exit, exit);
+            m_enterSlots.Erase(entity);
+            m_freeSlots.push_back(enter);
+            return true;
+        }
+
+        /// @brief Check whether ancestor is a proper ancestor of entity
+        bool IsAncestor(Entity entity, Entity ancestor) const
+        {
+            const Slot* slot = m_enterSlots.Find(entity);
+            const Slot* ancestorSlot = m_enterSlots.Find(ancestor);
+            if (!slot || !ancestorSlot || *slot == *ancestorSlot)
+            {
+                return false;
+            }
+
+            return m_nodes[*ancestorSlot].label < m_nodes[*slot].label
+                && m_nodes[*slot + 1].label < m_nodes[*ancestorSlot + 1].label;
+        }
+
+        /// @return 0 if the entity is not in the order
+        uint32_t GetDepth(Entity entity) const
+        {
+            const Slot* slot = m_enterSlots.Find(entity);
+            return slot ? m_nodes[*slot].depth : 0;
+        }
+
+        /// @return The entity itself if it is not in the order
+        Entity GetRoot(Entity entity) const
+        {
+            const Slot* slot = m_enterSlots.Find(entity);
+            return slot ? m_nodes[*slot].root : entity;
+        }
+
+        void Clear()
+        {
+            m_nodes.resize(2);
+            m_nodes[Sentinel] = Node{};
+            m_freeSlots.clear();
+            m_enterSlots.Clear();
+        }
+
+        /// @brief Visit all entities in DFS order
+        /// @param func void(Entity entity, uint32_t depth)
+        template<typename Func>
+        void ForEach(Func&& func) const
+        {
+            uint32_t depth = 0;
+            for (Slot cur = m_nodes[Sentinel].next; cur != Sentinel; cur = m_nodes[cur].next)
+            {
+                if (IsExit(cur))
+                {
+                    --depth;
+                    continue;
+                }
+
+                func(m_nodes[cur].entity, depth);
+                ++depth;
+            }
+        }
+
+    private:
+        static bool IsExit(Slot slot)
+        {
+            return slot & 1u;
+        }
+
+        Slot AllocateSlots(Entity entity)
+        {
+            Slot enter;
+            if (!m_freeSlots.empty())
+            {
+                enter = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+            else
+            {
+                enter = static_cast<Slot>(m_nodes.size());
+                m_nodes.resize(m_nodes.size() + 2);
+            }
+
+            m_nodes[enter].entity = entity;
+            m_nodes[enter + 1].entity = entity;
+            m_enterSlots.InsertOrAssign(entity, enter);
+            return enter;
+        }
+
+        /// @brief Get the token after which a subtree should be linked
+        Slot GetInsertPosition(Entity parent, Entity prevSibling) const
+        {
+            if (prevSibling != NullEntity)
+            {
+                if (const Slot* slot = m_enterSlots.Find(prevSibling))
+                {
+                    return *slot + 1;
+                }
+            }
+
+            if (parent != NullEntity)
+            {
+                if (const Slot* slot = m_enterSlots.Find(parent))
+                {
+                    return *slot;
+                }
+            }
+
+            return m_nodes[Sentinel].prev;
+        }
+
+        /// @brief Give labels to count tokens which have just been linked after the token after.
+        ///  The window grows over aligned label blocks of 2, 4, 8 ... labels around the label of after, in both
+        ///  directions, until the tokens inside the block are sparse enough (fewer than (2 / Density)^level),
+        ///  then the tokens of the block are spread evenly over it. This keeps amortized O(log^2 n) relabels per
+        ///  insertion, appending at the tail included, and the whole list is only relabeled when it is dense.
+        void AssignLabels(Slot after, uint32_t count)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+
+            const Label base = after == Sentinel ? MinLabel : m_nodes[after].label;
+            Slot first = after == Sentinel ? m_nodes[Sentinel].next : after;
+            Slot last = after;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                last = m_nodes[last].next;
+            }
+            uint64_t n = count + (after == Sentinel ? 0 : 1);
+
+            double capacity = 1.0;
+            for (uint32_t level = 1; ; ++level)
+            {
+                const bool whole = level >= 64;
+                const Label mask = whole ? MaxLabel : (Label(1) << level) - 1;
+                const Label low = base & ~mask;
+                const Label high = base | mask;
+
+                while (m_nodes[first].prev != Sentinel && m_nodes[m_nodes[first].prev].label >= low)
+                {
+                    first = m_nodes[first].prev;
+                    ++n;
+                }
+                while (m_nodes[last].next != Sentinel && m_nodes[m_nodes[last].next].label <= high)
+                {
+                    last = m_nodes[last].next;
+                    ++n;
+                }
+
+                capacity *= 2.0 / Density;
+                if (whole || (double(n) < capacity && high - low > n))
+                {
+                    // 标号严格位于(low, high)之间，不会与块外的节点或哨兵的标号重合
+                    const Label step = (high - low) / (n + 1);
+                    Slot cur = first;
+                    for (uint64_t i = 1; i <= n; ++i)
+                    {
+                        m_nodes[cur].label = low + step * i;
+                        cur = m_nodes[cur].next;
+                    }
+                    return;
+                }
+            }
+        }
+
+        void Unlink(Slot first, Slot last)
+        {
+            Slot prev = m_nodes[first].prev;
+            Slot next = m_nodes[last].next;
+            m_nodes[prev].next = next;
+            m_nodes[next].prev = prev;
+        }
+
+        void Link(Slot first, Slot last, Slot after)
+        {
+            Slot next = m_nodes[after].next;
+            m_nodes[after].next = first;
+            m_nodes[first].prev = after;
+            m_nodes[last].next = next;
+            m_nodes[next].prev = last;
+        }
+
+        eastl::vector<Node> m_nodes;
+        eastl::vector<Slot> m_freeSlots;
+        EntityMap<Slot> m_enterSlots;
+    };
+}
@@ -6,8 +6,11 @@
 #include <EASTL/span.h>
 #include <EASTL/set.h>
 #include <EASTL/functional.h>
+#include <EASTL/algorithm.h>
 
 #include <ECS/Entity.h>
+#include <Jobs/IJobSystem.h>
+#include <Service/Service.h>
 
 namespace Spark
 {
@@ -15,6 +18,7 @@ namespace Spark
     *  查询场景中的Entity信息
     */
     class WorldContext;
+    class Prefab;
 
     class IScene
     {
@@ -41,10 +45,12 @@ namespace Spark
 
         virtual Entity GetEntityRoot(Entity entity) const = 0;
 
+        /// @brief Get root entities, inside a batch the result is stale until the outermost batch ends
         virtual eastl::vector<Entity> GetRootEntities() const = 0;
 
         virtual eastl::vector<Entity> GetRootEntities(eastl::function<bool(Entity, Entity)> compare) const = 0;
 
+        /// @brief Get children of an entity in sibling order, inside a batch the result is stale until the outermost batch ends
         virtual eastl::vector<Entity> GetChildren(Entity entity) const = 0;
 
         virtual size_t GetDepth(Entity entity) const = 0;
@@ -54,6 +60,30 @@ namespace Spark
         ///         pair.second -- entity's depth
         virtual eastl::vector<eastl::pair<Entity, uint32_t>> GetEntityTree() const = 0;
 
+        // 以下View接口不拷贝数据，直接返回场景内部缓存。
+        // 返回的span在下一次Hierarchy改变（添加、移除实体，SetParent，修改Hierarchy组件，EndBatch）之前有效，
+        // 之后必须重新获取。批处理中返回的内容可能是过期的，与对应的拷贝接口相同。
+        // GetRootEntitiesView和GetChildrenView可以在声明了Read<Hierarchy>的并发tick中调用（子节点数组在加锁后按需重建）；
+        // DFS树相关接口（GetEntityTree、GetEntityTreeView、GetEntityTreeRange、GetSubtreeView）在读取时按需重建缓存，
+        // 只能在独占的tick或同步点调用。
+
+        /// @brief Get root entities without copy, the order is unspecified
+        virtual eastl::span<const Entity> GetRootEntitiesView() const = 0;
+
+        /// @brief Get children of an entity without copy, in sibling order
+        virtual eastl::span<const Entity> GetChildrenView(Entity entity) const = 0;
+
+        /// @brief Get DFS tree of all entities in scene without copy
+        virtual eastl::span<const eastl::pair<Entity, uint32_t>> GetEntityTreeView() const = 0;
+
+        /// @brief Get entries [first, first + count) of the DFS tree without copy,
+        ///  the range is clamped to the size of the tree
+        virtual eastl::span<const eastl::pair<Entity, uint32_t>> GetEntityTreeRange(size_t first, size_t count) const = 0;
+
+        /// @brief Get DFS tree entries of an entity and all its descendants without copy, the entity is the first entry
+        /// @return An empty span if the entity is not in scene
+        virtual eastl::span<const eastl::pair<Entity, uint32_t>> GetSubtreeView(Entity entity) const = 0;
+
         /// @brief Set an entity's parent, it will remove entity's old hierarchy relationship,
         ///  if prevSibling or parent does not have hierarchy, add hierarchy to it.
         /// @param entity 
@@ -61,7 +91,91 @@ namespace Spark
         /// @param prevSibling The previous sibling of this entity, if it not be assigned, the entity will be set to the first child of the parent
         virtual void SetParent(Entity entity, Entity parent, Entity prevSibling = NullEntity) = 0;
 
+        /// @brief Call func on an entity and all its descendants in DFS order, the callback must not change the hierarchy.
+        ///  Prefer ForEachInSubtree which does not go through eastl::function.
         virtual void PatchEntityHierarchy(Entity entity, eastl::function<void(Entity)> func) = 0;
 
+        /// @brief Visit an entity and all its descendants in DFS order, the callback is inlined and nothing is allocated.
+        ///  The callback can modify components but must not change the hierarchy (see the View interfaces above).
+        /// @param func void(Entity entity)
+        template<typename Func>
+        void ForEachInSubtree(Entity entity, Func&& func) const
+        {
+            for (const auto& node: GetSubtreeView(entity))
+            {
+                func(node.first);
+            }
+        }
+
+        /// @brief Same as ForEachInSubtree, but the subtree is split into chunks of at least grain entities which are
+        ///  visited by the jobs of IJobSystem. The visiting order is unspecified and the callback must be thread safe,
+        ///  the subtree is visited on the calling thread if there is no IJobSystem.
+        /// @param func void(Entity entity)
+        template<typename Func>
+        void ParallelForEachInSubtree(Entity entity, Func&& func, size_t grain = 1024) const
+        {
+            IJobSystem* jobSystem = Service<IJobSystem>::Get();
+            if (!jobSystem)
+            {
+                ForEachInSubtree(entity, func);
+                return;
+            }
+
+            auto nodes = GetSubtreeView(entity);
+            jobSystem->ParallelFor(0, nodes.size(), [&nodes, &func](size_t first, size_t last)
+            {
+                for (size_t i = first; i < last; ++i)
+                {
+                    func(nodes[i].first);
+                }
+            }, grain);
+        }
+
+        /// @brief Begin a batch of hierarchy edits, batches can be nested.
+        ///  Inside a batch the Hierarchy events are only recorded, they are validated and applied in one pass when
+        ///  the outermost batch ends. Until then every query (Contain, GetRootEntities, GetChildren, GetDepth,
+        ///  GetEntityTree and the views) returns the state before the batch, and the Hierarchy components of
+        ///  the neighbours of an edited entity are not updated.
+        ///
+        ///  When the batch is applied an entity is placed after the parent and previous sibling it references,
+        ///  so a child can be added before its parent. The position is taken from parent and prevSibling only:
+        ///  nextSibling is resolved again, and an entity without prevSibling becomes the first child of its parent.
+        virtual void BeginBatch() = 0;
+
+        /// @brief End a batch of hierarchy edits, the outermost batch applies all recorded events
+        virtual void EndBatch() = 0;
+
+        virtual bool IsInBatch() const = 0;
+
+        /// @brief WorldContext::Instantiate in the world of the scene inside one batch,
+        ///  so the Hierarchy components of all instances are applied in one pass
+        virtual void Instantiate(const Prefab& prefab, size_t count, eastl::span<Entity> entities) = 0;
+    };
+
+    /// @brief RAII helper of IScene::BeginBatch/EndBatch
+    class SceneBatchScope final
+    {
+    public:
+        explicit SceneBatchScope(IScene* scene) : m_scene(scene)
+        {
+            if (m_scene)
+            {
+                m_scene->BeginBatch();
+            }
+        }
+
+        ~SceneBatchScope()
+        {
+            if (m_scene)
+            {
+                m_scene->EndBatch();
+            }
+        }
+
+        SceneBatchScope(const SceneBatchScope&) = delete;
+        SceneBatchScope& operator=(const SceneBatchScope&) = delete;
+
+    private:
+        IScene* m_scene {nullptr};
     };
 }
\ No newline at end of file
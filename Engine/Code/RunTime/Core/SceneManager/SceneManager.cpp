@@ -1,7 +1,7 @@
 #include "SceneManager.h"
 
-#include <EASTL/stack.h>
 #include <EASTL/sort.h>
+#include <EASTL/algorithm.h>
 
 #include <Log/SpdLogSystem.h>
 #include <ECS/Tag.h>
@@ -17,18 +17,28 @@ namespace Spark
 
     void SceneManager::ShutDown()
     {
-        m_roots.clear();
-        m_childrenMap.clear();
-        m_entities.clear();
-        m_componentCache.clear();
+        m_roots.Clear();
+        m_childrenMap.Clear();
+        m_entities.Clear();
+        m_componentCache.Clear();
+        m_entityOrder.Clear();
         m_entityDFSTree.clear();
+        m_entityTreeIndices.Clear();
+        m_entityTreeDirty = false;
+        m_dirtyParents.Clear();
+        m_childrenDirty = false;
+        m_dirtyRoots.clear();
+        m_pendingEvents.Clear();
+        m_pendingOrder.clear();
+        m_touched.Clear();
+        m_batchDepth = 0;
 
         ComponentEventBus::Handler::BusDisconnect(GetTypeId<Hierarchy>());
     }
 
     size_t SceneManager::GetEntityCount() const
     {
-        return m_entities.size();
+        return m_entities.Size();
     }
 
     void SceneManager::AddEntity(Entity entity)
@@ -56,7 +66,9 @@ namespace Spark
             }
         }
 
+        BeginBatch();
         m_context.Add<Hierarchy>(entities.begin(), entities.end(), Hierarchy{});
+        EndBatch();
     }
 
     void SceneManager::RemoveEntity(Entity entity)
@@ -84,7 +96,9 @@ namespace Spark
             }
         }
 
+        BeginBatch();
         m_context.Remove<Hierarchy>(entities.begin(), entities.end());
+        EndBatch();
     }
 
     bool SceneManager::Contain(Entity entity) const
@@ -95,64 +109,38 @@ namespace Spark
             return false;
         }
 
-        return m_entities.contains(entity);
+        return m_entities.Contains(entity);
     }
 
     eastl::vector<Entity> SceneManager::GetHierarchyPath(Entity entity) const
     {
-        eastl::vector<Entity> ancestors;
+        // 深度已知，从后往前填充，每层只查询一次Hierarchy
+        eastl::vector<Entity> ancestors(m_entityOrder.GetDepth(entity), NullEntity);
 
         Entity cur = entity;
-        while(m_context.Has<Hierarchy>(cur))
+        for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it)
         {
-            Entity parent = m_context.Get<Hierarchy>(cur).parent;
-            if (parent == NullEntity)
+            const Hierarchy* hierarchy = m_context.TryGet<Hierarchy>(cur);
+            if (!hierarchy || hierarchy->parent == NullEntity)
             {
+                LOG_ERROR("[SceneManager] GetHierarchyPath: An error has occurred in entity hierarchy.");
                 break;
             }
-            ancestors.push_back(parent);
-            cur = parent;
+            cur = hierarchy->parent;
+            *it = cur;
         }
 
-        eastl::reverse(ancestors.begin(), ancestors.end());
         return ancestors;
     }
 
     bool SceneManager::IsAncestor(Entity entity, Entity ancestor) const
     {
-        Entity cur = entity;
-        while(m_context.Has<Hierarchy>(cur))
-        {
-            Entity parent = m_context.Get<Hierarchy>(cur).parent;
-            if (parent == NullEntity)
-            {
-                break;
-            }
-
-            if (ancestor == parent)
-            {
-                return true;
-            }
-            cur = parent;
-        }
-        return false;
+        return m_entityOrder.IsAncestor(entity, ancestor);
     }
 
     Entity SceneManager::GetEntityRoot(Entity entity) const
     {
-        Entity cur = entity;
-        while(m_context.Has<Hierarchy>(cur))
-        {
-            Entity parent = m_context.Get<Hierarchy>(cur).parent;
-            if (parent == NullEntity)
-            {
-                break;
-            }
-
-            cur = parent;
-        }
-
-        return cur;
+        return m_entityOrder.GetRoot(entity);
     }
 
     eastl::vector<Entity> SceneManager::GetRootEntities() const
@@ -169,66 +157,89 @@ namespace Spark
 
     eastl::vector<Entity> SceneManager::GetChildren(Entity entity) const
     {
-        eastl::vector<Entity> children;
-        auto it = m_childrenMap.find(entity);
-        if (it != m_childrenMap.end())
-        {
-            children = it->second;
-        }
-        return children;
+        auto children = GetChildrenView(entity);
+        return eastl::vector<Entity>(children.begin(), children.end());
     }
 
-    size_t SceneManager::GetDepth(Entity entity) const
+    eastl::span<const Entity> SceneManager::GetRootEntitiesView() const
     {
-        size_t depth = 0;
+        return m_roots.Entities();
+    }
 
-        Entity cur = entity;
-        while(m_context.Has<Hierarchy>(cur))
+    eastl::span<const Entity> SceneManager::GetChildrenView(Entity entity) const
+    {
+        UpdateChildrenMap();
+        if (auto cached = m_childrenMap.Find(entity))
         {
-            Entity parent = m_context.Get<Hierarchy>(cur).parent;
-            if (parent == NullEntity)
-            {
-                break;
-            }
-            depth++;
-            cur = parent;
+            return eastl::span<const Entity>(cached->data(), cached->size());
         }
+        return {};
+    }
 
-        return depth;
+    size_t SceneManager::GetDepth(Entity entity) const
+    {
+        return m_entityOrder.GetDepth(entity);
     }
 
     eastl::vector<eastl::pair<Entity, unsigned int>> SceneManager::GetEntityTree() const
     {
+        UpdateEntityTree();
         return m_entityDFSTree;
     }
 
-    void SceneManager::UpdateEntityTree()
+    eastl::span<const eastl::pair<Entity, uint32_t>> SceneManager::GetEntityTreeView() const
     {
-        eastl::vector<Entity> roots = GetRootEntities();
+        UpdateEntityTree();
+        return eastl::span<const eastl::pair<Entity, uint32_t>>(m_entityDFSTree.data(), m_entityDFSTree.size());
+    }
 
-        m_entityDFSTree.clear();
-        m_entityDFSTree.reserve(m_entities.size());
-        for (auto root: roots)
+    eastl::span<const eastl::pair<Entity, uint32_t>> SceneManager::GetEntityTreeRange(size_t first, size_t count) const
+    {
+        auto tree = GetEntityTreeView();
+        if (first >= tree.size())
         {
-            eastl::stack<eastl::pair<Entity, uint32_t>> traversalStack;
-            traversalStack.emplace(root, 0);
-            while (!traversalStack.empty())
-            {
-                auto cur = traversalStack.top();
-                traversalStack.pop();
+            return {};
+        }
+        return tree.subspan(first, eastl::min(count, tree.size() - first));
+    }
 
-                m_entityDFSTree.emplace_back(cur);
+    eastl::span<const eastl::pair<Entity, uint32_t>> SceneManager::GetSubtreeView(Entity entity) const
+    {
+        auto tree = GetEntityTreeView();
+        const uint32_t* index = m_entityTreeIndices.Find(entity);
+        if (!index)
+        {
+            return {};
+        }
 
-                eastl::vector<Entity> children = GetChildren(cur.first);
-                uint32_t depth = cur.second + 1;
-                for (auto it = children.rbegin(); it != children.rend(); it++)
-                {
-                    traversalStack.emplace(eastl::make_pair<Entity, uint32_t>(*it, depth));
-                }
-            }
+        // 子树结束于下一个深度不大于该节点的位置
+        const uint32_t depth = tree[*index].second;
+        size_t last = *index + 1;
+        while (last < tree.size() && tree[last].second > depth)
+        {
+            ++last;
         }
+        return tree.subspan(*index, last - *index);
+    }
 
-        if (m_entityDFSTree.size() != m_entities.size())
+    void SceneManager::UpdateEntityTree() const
+    {
+        if (!m_entityTreeDirty)
+        {
+            return;
+        }
+
+        m_entityDFSTree.clear();
+        m_entityDFSTree.reserve(m_entities.Size());
+        m_entityTreeIndices.Clear();
+        m_entityTreeIndices.Reserve(m_entities.Size());
+        m_entityOrder.ForEach([this](Entity entity, uint32_t depth){
+            m_entityTreeIndices.InsertOrAssign(entity, static_cast<uint32_t>(m_entityDFSTree.size()));
+            m_entityDFSTree.emplace_back(entity, depth);
+        });
+        m_entityTreeDirty = false;
+
+        if (m_entityDFSTree.size() != m_entities.Size())
         {
             LOG_ERROR("[SceneManager] UpdateEntityTree: An error has occurred in entity hierarchy.");
         }
@@ -268,69 +279,119 @@ namespace Spark
             next = m_context.Get<Hierarchy>(parent).firstChild;
         }
 
+        // 在原来的父节点下移动时，下一个兄弟可能是实体自身
+        if (next == entity)
+        {
+            next = entityHier.nextSibling;
+        }
+
         entityHier.parent = parent;
         entityHier.prevSibling = prevSibling;
         entityHier.nextSibling = next;
         m_context.AddOrRepalce<Hierarchy>(entity, entityHier);
     }
 
-    void SceneManager::PatchEntityHierarchy(Entity entity, eastl::function<void(Entity)> func)
+    void SceneManager::BeginBatch()
     {
-        eastl::stack<Entity> traversalStack;
-        traversalStack.emplace(entity);
-        while (!traversalStack.empty())
-        {
-            auto cur = traversalStack.top();
-            traversalStack.pop();
+        ++m_batchDepth;
+    }
 
-            func(cur);
+    void SceneManager::EndBatch()
+    {
+        if (m_batchDepth == 0)
+        {
+            LOG_ERROR("[SceneManager] EndBatch: There is no batch to end");
+            return;
+        }
 
-            eastl::vector<Entity> children = GetChildren(cur);
-            for (auto it = children.rbegin(); it != children.rend(); it++)
-            {
-                traversalStack.emplace(*it);
-            }
+        if (--m_batchDepth == 0)
+        {
+            ApplyPendingEvents(true);
         }
     }
 
-    void SceneManager::UpdateChildrenMap(Entity entity)
+    bool SceneManager::IsInBatch() const
     {
-        if (entity == NullEntity)
+        return m_batchDepth > 0;
+    }
+
+    void SceneManager::Instantiate(const Prefab& prefab, size_t count, eastl::span<Entity> entities)
+    {
+        SceneBatchScope batch(this);
+        m_context.Instantiate(prefab, count, entities);
+    }
+
+    void SceneManager::FlushPendingUpdates()
+    {
+        // children map在下一次读取时重建，避免每个事件都遍历整个兄弟链表
+        if (!m_dirtyParents.Empty())
         {
-            LOG_ERROR("[SceneManager] UpdateChildrenMap: NullEntity does not have children map");
-            return;
+            m_childrenDirty.store(true, std::memory_order_release);
         }
 
-        if (!m_context.Has<Hierarchy>(entity))
+        eastl::sort(m_dirtyRoots.begin(), m_dirtyRoots.end());
+        m_dirtyRoots.erase(eastl::unique(m_dirtyRoots.begin(), m_dirtyRoots.end()), m_dirtyRoots.end());
+        for (Entity entity: m_dirtyRoots)
         {
-            LOG_ERROR("[SceneManager] UpdateChildrenMap: The entity does not have Hierarchy component");
-            return;
+            if (Contain(entity))
+            {
+                UpdateRoots(entity);
+            }
+            else
+            {
+                m_roots.Erase(entity);
+            }
         }
+        m_dirtyRoots.clear();
+    }
 
-        const auto hierarchy = m_context.Get<Hierarchy>(entity);
-        eastl::vector<Entity> newChildren;
-        Entity cur = hierarchy.firstChild;
-        while(cur != NullEntity)
+    void SceneManager::PatchEntityHierarchy(Entity entity, eastl::function<void(Entity)> func)
+    {
+        // 不在场景中的实体只处理自身
+        if (!m_entities.Contains(entity))
         {
-            newChildren.push_back(cur);
-            cur = m_context.Has<Hierarchy>(cur) ? m_context.Get<Hierarchy>(cur).nextSibling : NullEntity;
+            func(entity);
+            return;
         }
 
-        if (newChildren.empty())
+        ForEachInSubtree(entity, func);
+    }
+
+    void SceneManager::UpdateChildrenMap() const
+    {
+        if (!m_childrenDirty.load(std::memory_order_acquire))
         {
-            m_childrenMap.erase(entity);
             return;
         }
 
-        auto it = m_childrenMap.find(entity);
-        if (it != m_childrenMap.end())
+        // 并发的读取者只有一个重建，其他等待重建完成
+        std::lock_guard<std::mutex> lock(m_childrenMutex);
+        if (!m_childrenDirty.load(std::memory_order_relaxed))
         {
-            newChildren.swap(it->second);
+            return;
         }
-        else
+
+        for (Entity parent : m_dirtyParents)
         {
-            m_childrenMap[entity] = newChildren;
+            const Hierarchy* hierarchy = m_componentCache.Find(parent);
+            if (!hierarchy || hierarchy->firstChild == NullEntity)
+            {
+                m_childrenMap.Erase(parent);
+                continue;
+            }
+
+            eastl::vector<Entity>& children = m_childrenMap[parent];
+            children.clear();
+            Entity cur = hierarchy->firstChild;
+            while(cur != NullEntity)
+            {
+                children.push_back(cur);
+                const Hierarchy* curHier = m_componentCache.Find(cur);
+                cur = curHier ? curHier->nextSibling : NullEntity;
+            }
         }
+        m_dirtyParents.Clear();
+        m_childrenDirty.store(false, std::memory_order_release);
     }
 
     void SceneManager::UpdateRoots(Entity entity)
@@ -341,19 +402,20 @@ namespace Spark
             return;
         }
 
-        if (!m_context.Has<Hierarchy>(entity))
+        const Hierarchy* hierarchy = m_componentCache.Find(entity);
+        if (!hierarchy)
         {
-            LOG_ERROR("[SceneManager] UpdateRoots: The entity does not have Hierarchy component");
+            LOG_ERROR("[SceneManager] UpdateRoots: The entity is not in scene");
             return;
         }
 
-        if (m_context.Get<Hierarchy>(entity).parent != NullEntity)
+        if (hierarchy->parent != NullEntity)
         {
-            m_roots.erase(entity);
+            m_roots.Erase(entity);
         }
         else
         {
-            m_roots.insert(entity);
+            m_roots.Insert(entity);
         }
     }
 
@@ -393,13 +455,13 @@ namespace Spark
 
             if (hierarchy.prevSibling != NullEntity)
             {
-                Entity siblingParent = m_context.Get<Hierarchy>(hierarchy.prevSibling).parent;
+                Entity siblingParent = m_componentCache.Find(hierarchy.prevSibling)->parent;
                 if (siblingParent != hierarchy.parent)
                 {
                     LOG_ERROR("[SceneManager] Valid: Entity and its previous sibling has a different parent.");
                     return false;
                 }
-                Entity next = m_context.Get<Hierarchy>(hierarchy.prevSibling).nextSibling;
+                Entity next = m_componentCache.Find(hierarchy.prevSibling)->nextSibling;
                 if (next != hierarchy.nextSibling)
                 {
                     LOG_ERROR("[SceneManager] Valid: The previous sibling has a next entity and it is different from the nextSibling in this Hierarchy.");
@@ -409,36 +471,25 @@ namespace Spark
 
             if (hierarchy.nextSibling != NullEntity)
             {
-                Entity siblingParent = m_context.Get<Hierarchy>(hierarchy.nextSibling).parent;
+                Entity siblingParent = m_componentCache.Find(hierarchy.nextSibling)->parent;
                 if (siblingParent != hierarchy.parent)
                 {
                     LOG_ERROR("[SceneManager] Valid: Entity and its next sibling has a different parent.");
                     return false;
                 }
-                Entity prev = m_context.Get<Hierarchy>(hierarchy.nextSibling).prevSibling;
+                Entity prev = m_componentCache.Find(hierarchy.nextSibling)->prevSibling;
                 if (prev != hierarchy.prevSibling)
                 {
                     LOG_ERROR("[SceneManager] Valid: The next sibling has a previous entity and it is different from the prevSibling in this Hierarchy.");
                     return false;
                 }
             }
-
-            if (hierarchy.prevSibling != NullEntity && hierarchy.nextSibling != NullEntity)
-            {
-                Entity next = m_context.Get<Hierarchy>(hierarchy.prevSibling).nextSibling;
-                Entity prev = m_context.Get<Hierarchy>(hierarchy.nextSibling).prevSibling;
-                if (next != prev)
-                {
-                    LOG_ERROR("[SceneManager] Valid: Hierarchy both set prevSibling and nextSibling but they are not adjacent now.");
-                    return false;
-                }
-            }
         }
         else  // both prev and next are null
         {
             if (hierarchy.parent != NullEntity)
             {
-                if (m_context.Get<Hierarchy>(hierarchy.parent).firstChild != NullEntity)
+                if (m_componentCache.Find(hierarchy.parent)->firstChild != NullEntity)
                 {
                     LOG_ERROR("[SceneManager] Valid: The parent entity already has child,"
                         "but Hierarchy have not specified the insertion position for this entity."
@@ -451,236 +502,390 @@ namespace Spark
         return true;
     }
 
-    void SceneManager::ForEachChild(const Hierarchy& hierarchy, eastl::function<void(Entity entity)> func)
+    Hierarchy* SceneManager::GetComponent(Entity entity)
     {
-        Entity cur = hierarchy.firstChild;
-        while(cur != NullEntity && m_context.Has<Hierarchy>(cur))
+        return m_context.Valid(entity) ? m_context.TryGet<Hierarchy>(entity) : nullptr;
+    }
+
+    Hierarchy& SceneManager::EditHierarchy(Entity entity)
+    {
+        assert(m_componentCache.Contains(entity) && "[SceneManager] Editing the hierarchy of an entity which is not in scene");
+        m_touched.Insert(entity);
+        return m_componentCache[entity];
+    }
+
+    void SceneManager::ResolveSiblings(Hierarchy& hierarchy) const
+    {
+        // 批处理中其他实体的组件可能已经过期，位置只由parent和prevSibling决定
+        if (hierarchy.prevSibling != NullEntity)
+        {
+            const Hierarchy* prevSiblingHier = m_componentCache.Find(hierarchy.prevSibling);
+            if (prevSiblingHier && prevSiblingHier->parent == hierarchy.parent)
+            {
+                hierarchy.nextSibling = prevSiblingHier->nextSibling;
+            }
+        }
+        else if (hierarchy.parent != NullEntity)
         {
-            func(cur);
-            cur = m_context.Get<Hierarchy>(cur).nextSibling;
+            if (const Hierarchy* parentHier = m_componentCache.Find(hierarchy.parent))
+            {
+                hierarchy.nextSibling = parentHier->firstChild;
+            }
+        }
+        else
+        {
+            hierarchy.nextSibling = NullEntity;
         }
     }
 
-    void SceneManager::RemoveEntityInternal(const Hierarchy& hierarchy)
+    void SceneManager::LinkEntity(Entity entity, Hierarchy hierarchy)
     {
         Entity parent = hierarchy.parent;
         Entity prevSibling = hierarchy.prevSibling;
         Entity nextSibling = hierarchy.nextSibling;
-        Entity firstChild = hierarchy.firstChild;
 
         if (parent != NullEntity)
         {
+            // 插入至第一个子节点
             if (prevSibling == NullEntity)
             {
-                auto& parentHier = m_context.Get<Hierarchy>(parent);
-                parentHier.firstChild = nextSibling;
-                m_componentCache[parent] = parentHier;
+                EditHierarchy(parent).firstChild = entity;
             }
-            m_updateFunctions.emplace([this, parent](){UpdateChildrenMap(parent);});
+            m_dirtyParents.Insert(parent);
         }
 
-        // 子节点上升至父节点的父节点
-        Entity cur = firstChild;
-        Entity first = cur;
-        Entity last = cur;
-        bool isFirst = true;
-        ForEachChild(hierarchy, [&](Entity child){
-            auto& curHier = m_context.Get<Hierarchy>(child);
-            if (isFirst && parent != NullEntity)
-            {
-                auto& parentHier =  m_context.Get<Hierarchy>(parent);
-                if (parentHier.firstChild == NullEntity)
-                {
-                    parentHier.firstChild = child;
-                }
-                isFirst = false;
-            }
-            curHier.parent = parent;
-            m_componentCache[child] = curHier;
-            m_updateFunctions.emplace([this, child](){UpdateRoots(child);});
-            last = child;
-        });
+        if (prevSibling == NullEntity && nextSibling != NullEntity)
+        {
+            prevSibling = m_componentCache.Find(nextSibling)->prevSibling;
+        }
+
+        if (prevSibling != NullEntity && nextSibling == NullEntity)
+        {
+            nextSibling = m_componentCache.Find(prevSibling)->nextSibling;
+        }
 
         if (prevSibling != NullEntity)
         {
-            auto& prevSiblingHier = m_context.Get<Hierarchy>(prevSibling);
-            if (first != NullEntity)
-            {
-                auto& firstHier = m_context.Get<Hierarchy>(first);
-                firstHier.prevSibling = prevSibling;
-                prevSiblingHier.nextSibling = first;
-                m_componentCache[first] = firstHier;
-            }
-            else
-            {
-                prevSiblingHier.nextSibling = nextSibling;
-            }
-            m_componentCache[prevSibling] = prevSiblingHier;
+            EditHierarchy(prevSibling).nextSibling = entity;
+            m_dirtyRoots.push_back(prevSibling);
         }
 
         if (nextSibling != NullEntity)
         {
-            auto& nextSiblingHier = m_context.Get<Hierarchy>(nextSibling);
-            if (last != NullEntity)
-            {
-                auto& lastHier = m_context.Get<Hierarchy>(last);
-                lastHier.nextSibling = nextSibling;
-                nextSiblingHier.prevSibling = last;
-                m_componentCache[last] = lastHier;
-            }
-            else
+            EditHierarchy(nextSibling).prevSibling = entity;
+            m_dirtyRoots.push_back(nextSibling);
+        }
+
+        hierarchy.prevSibling = prevSibling;
+        hierarchy.nextSibling = nextSibling;
+        EditHierarchy(entity) = hierarchy;
+        m_dirtyRoots.push_back(entity);
+    }
+
+    void SceneManager::UnlinkEntity(const Hierarchy& hierarchy)
+    {
+        if (hierarchy.parent != NullEntity)
+        {
+            if (hierarchy.prevSibling == NullEntity)
             {
-                nextSiblingHier.prevSibling = prevSibling;
+                EditHierarchy(hierarchy.parent).firstChild = hierarchy.nextSibling;
             }
-            m_componentCache[nextSibling] = nextSiblingHier;
+            m_dirtyParents.Insert(hierarchy.parent);
+        }
+
+        if (hierarchy.prevSibling != NullEntity)
+        {
+            EditHierarchy(hierarchy.prevSibling).nextSibling = hierarchy.nextSibling;
+        }
+
+        if (hierarchy.nextSibling != NullEntity)
+        {
+            EditHierarchy(hierarchy.nextSibling).prevSibling = hierarchy.prevSibling;
         }
     }
 
-    void SceneManager::AddEntityInternal(Entity entity)
+    void SceneManager::RemoveEntityInternal(Entity entity, const Hierarchy& hierarchy)
     {
-        const auto hier = m_context.Get<Hierarchy>(entity);
+        // 子节点在DFS序中原地保留，自然占据该节点的位置
+        m_entityOrder.Remove(entity);
 
-        Entity parent = hier.parent;
-        Entity prevSibling = hier.prevSibling;
-        Entity nextSibling = hier.nextSibling;
-        Entity firstChild = hier.firstChild;
+        Entity parent = hierarchy.parent;
+        Entity prevSibling = hierarchy.prevSibling;
+        Entity nextSibling = hierarchy.nextSibling;
 
-        if (parent != NullEntity)
+        // 子节点上升至父节点的父节点，在兄弟链表中占据该节点的位置，根节点的子节点成为没有兄弟的根节点
+        Entity first = hierarchy.firstChild;
+        Entity last = NullEntity;
+        for (Entity child = first; child != NullEntity && m_componentCache.Contains(child); )
         {
-            // 插入至第一个子节点
-            if (prevSibling == NullEntity)
+            Hierarchy& childHier = EditHierarchy(child);
+            const Entity next = childHier.nextSibling;
+            childHier.parent = parent;
+            if (parent == NullEntity)
             {
-                auto& parentHier = m_context.Get<Hierarchy>(parent);
-                parentHier.firstChild = entity;
-                m_componentCache[parent] = parentHier;
+                childHier.prevSibling = NullEntity;
+                childHier.nextSibling = NullEntity;
             }
-            m_updateFunctions.emplace([this, parent](){ 
-                UpdateChildrenMap(parent);
-            });
+            m_dirtyRoots.push_back(child);
+            last = child;
+            child = next;
         }
-
-        if (prevSibling == NullEntity && nextSibling != NullEntity)
+        if (last == NullEntity || parent == NullEntity)
+        {
+            first = NullEntity;
+            last = NullEntity;
+        }
+        else
         {
-            prevSibling = m_context.Get<Hierarchy>(nextSibling).prevSibling;
+            EditHierarchy(first).prevSibling = prevSibling;
+            EditHierarchy(last).nextSibling = nextSibling;
         }
 
-        if (prevSibling != NullEntity && nextSibling == NullEntity)
+        const Entity head = first != NullEntity ? first : nextSibling;
+        const Entity tail = last != NullEntity ? last : prevSibling;
+        if (parent != NullEntity)
         {
-            nextSibling = m_context.Get<Hierarchy>(prevSibling).nextSibling;
+            if (prevSibling == NullEntity)
+            {
+                EditHierarchy(parent).firstChild = head;
+            }
+            m_dirtyParents.Insert(parent);
         }
 
         if (prevSibling != NullEntity)
         {
-            auto& prevSiblingHier = m_context.Get<Hierarchy>(prevSibling);
-            prevSiblingHier.nextSibling = entity;
-            m_componentCache[prevSibling] = prevSiblingHier;
-            m_updateFunctions.emplace([this, prevSibling](){UpdateRoots(prevSibling);});
+            EditHierarchy(prevSibling).nextSibling = head;
         }
 
         if (nextSibling != NullEntity)
         {
-            auto& nextSiblingHier = m_context.Get<Hierarchy>(nextSibling);
-            nextSiblingHier.prevSibling = entity;
-            m_componentCache[nextSibling] = nextSiblingHier;
-            m_updateFunctions.emplace([this, nextSibling](){UpdateRoots(nextSibling);});
+            EditHierarchy(nextSibling).prevSibling = tail;
         }
+    }
+
+    void SceneManager::AddEntityInternal(Entity entity, const Hierarchy& hierarchy)
+    {
+        m_entities.Insert(entity);
+        m_componentCache[entity] = hierarchy;
+        LinkEntity(entity, hierarchy);
+        m_entityOrder.Insert(entity, hierarchy.parent, m_componentCache.Find(entity)->prevSibling);
 
+        // 整棵子树移动到当前节点之下，从firstChild开始的兄弟节点都成为当前节点的子节点
         bool isFirst = true;
-        ForEachChild(hier, [&](Entity child){
-            auto& curHier = m_context.Get<Hierarchy>(child);
-            curHier.parent = entity;
+        Entity prevChild = NullEntity;
+        for (Entity child = hierarchy.firstChild; child != NullEntity && m_componentCache.Contains(child); )
+        {
+            m_entityOrder.Move(child, entity, prevChild);
+            prevChild = child;
+
+            Hierarchy& childHier = EditHierarchy(child);
             if (isFirst)
             {
-                Entity prev = curHier.prevSibling;
+                Entity oldParent = childHier.parent;
+                Entity prev = childHier.prevSibling;
                 if (prev != NullEntity)
                 {
-                    auto& hier = m_context.Get<Hierarchy>(prev);
-                    hier.nextSibling = NullEntity;
-                    Entity oldParent = hier.parent;
-                    m_updateFunctions.emplace([this, oldParent](){UpdateChildrenMap(oldParent);});
+                    EditHierarchy(prev).nextSibling = NullEntity;
                 }
-                curHier.prevSibling = NullEntity;
-                m_updateFunctions.emplace([this, entity](){UpdateChildrenMap(entity);});
+                else if (oldParent != NullEntity && oldParent != entity)
+                {
+                    EditHierarchy(oldParent).firstChild = NullEntity;
+                }
+                if (oldParent != NullEntity)
+                {
+                    m_dirtyParents.Insert(oldParent);
+                }
+                childHier.prevSibling = NullEntity;
+                m_dirtyParents.Insert(entity);
                 isFirst = false;
             }
-            m_componentCache[child] = curHier;
-            m_updateFunctions.emplace([this, child](){UpdateRoots(child);});
-        }); 
+            childHier.parent = entity;
+            m_dirtyRoots.push_back(child);
+            child = childHier.nextSibling;
+        }
 
-        m_updateFunctions.emplace([this, entity](){UpdateRoots(entity);});
+        m_entityTreeDirty = true;
     }
 
-    void SceneManager::OnComponentConstruct(WorldContext& context, Entity entity)
+    void SceneManager::RemoveFromScene(Entity entity)
+    {
+        const Hierarchy hierarchy = *m_componentCache.Find(entity);
+        RemoveEntityInternal(entity, hierarchy);
+
+        m_componentCache.Erase(entity);
+        m_childrenMap.Erase(entity);
+        m_roots.Erase(entity);
+        m_entities.Erase(entity);
+        m_touched.Erase(entity);
+        m_entityTreeDirty = true;
+    }
+
+    void SceneManager::ApplyEvent(Entity entity, bool destory, bool resolveSiblings)
     {
-        const auto hier = context.Get<Hierarchy>(entity);
-        if (!Valid(hier))
+        const Hierarchy* component = destory ? nullptr : GetComponent(entity);
+        const Hierarchy* cached = m_componentCache.Find(entity);
+        if (!component)
         {
-            LOG_ERROR("[SceneManager] OnComponentConstruct: Hierarchy is invalid");
+            if (cached)
+            {
+                RemoveFromScene(entity);
+            }
             return;
         }
-        
-        AddEntityInternal(entity);
-        m_entities.insert(entity);
-        m_componentCache[entity] = hier;
 
-        while(!m_updateFunctions.empty())
+        Hierarchy hierarchy = *component;
+        if (!cached)
         {
-            auto func = m_updateFunctions.front();
-            func();
-            m_updateFunctions.pop();
+            if (resolveSiblings)
+            {
+                ResolveSiblings(hierarchy);
+            }
+            if (!Valid(hierarchy))
+            {
+                LOG_ERROR("[SceneManager] OnComponentConstruct: Hierarchy is invalid");
+                return;
+            }
+            AddEntityInternal(entity, hierarchy);
+            return;
         }
-        UpdateEntityTree();
-    }
 
-    void SceneManager::OnComponentUpdate(WorldContext& context, Entity entity)
-    {
-        const auto hier = context.Get<Hierarchy>(entity);
-        if (!Valid(hier))
+        const Hierarchy old = *cached;
+        const Entity parent = hierarchy.parent;
+        if (hierarchy.firstChild == old.firstChild && parent != entity && !m_entityOrder.IsAncestor(parent, entity))
         {
-            LOG_ERROR("[SceneManager] OnComponentUpdate: Hierarchy is invalid");
+            // 子节点不变时只把实体从兄弟链表中取出，整棵子树移动到新的位置
+            UnlinkEntity(old);
+            if (resolveSiblings)
+            {
+                ResolveSiblings(hierarchy);
+            }
+            if (!Valid(hierarchy))
+            {
+                LOG_ERROR("[SceneManager] OnComponentUpdate: Hierarchy is invalid");
+                LinkEntity(entity, old);
+                return;
+            }
+            LinkEntity(entity, hierarchy);
+            m_entityOrder.Move(entity, parent, m_componentCache.Find(entity)->prevSibling);
+            m_entityTreeDirty = true;
             return;
         }
 
-        if (!m_componentCache.contains(entity))
+        // 子节点改变或移动到自己的子树中时，先移除旧的层级（子节点上升至父节点），再按新的Hierarchy添加
+        if (!resolveSiblings && !Valid(hierarchy))
         {
-            OnComponentConstruct(context, entity);
+            LOG_ERROR("[SceneManager] OnComponentUpdate: Hierarchy is invalid");
             return;
         }
-        // process old hierarchy
-        auto cacheHierarchy = m_componentCache[entity];
-        RemoveEntityInternal(cacheHierarchy);
-
-        while(!m_updateFunctions.empty())
+        RemoveFromScene(entity);
+        if (resolveSiblings)
+        {
+            ResolveSiblings(hierarchy);
+        }
+        if (!Valid(hierarchy))
         {
-            auto func = m_updateFunctions.front();
-            func();
-            m_updateFunctions.pop();
+            LOG_ERROR("[SceneManager] OnComponentUpdate: Hierarchy is invalid");
+            return;
         }
+        AddEntityInternal(entity, hierarchy);
+    }
+
+    void SceneManager::ApplyWithDependencies(Entity entity, bool resolveSiblings)
+    {
+        // 先应用实体引用的、同一批次中尚未应用的父节点和前一个兄弟节点，所以批处理中可以先添加子节点再添加父节点
+        m_applyStack.push_back(entity);
+        while (!m_applyStack.empty())
+        {
+            const Entity cur = m_applyStack.back();
+            PendingEvent* pending = m_pendingEvents.Find(cur);
+            if (!pending)
+            {
+                m_applyStack.pop_back();
+                continue;
+            }
 
-        // update hierarchy
-        OnComponentConstruct(context, entity);
+            if (!pending->m_visited)
+            {
+                pending->m_visited = true;
+                const Hierarchy* component = pending->m_destory ? nullptr : GetComponent(cur);
+                if (component)
+                {
+                    for (Entity dependency : {component->parent, component->prevSibling})
+                    {
+                        const PendingEvent* other = m_pendingEvents.Find(dependency);
+                        if (other && !other->m_visited)
+                        {
+                            m_applyStack.push_back(dependency);
+                        }
+                    }
+                }
+                continue;
+            }
+
+            const bool destory = pending->m_destory;
+            m_pendingEvents.Erase(cur);
+            m_applyStack.pop_back();
+            ApplyEvent(cur, destory, resolveSiblings);
+        }
     }
 
-    void SceneManager::OnComponentDestory(WorldContext& context, Entity entity)
+    void SceneManager::ApplyPendingEvents(bool resolveSiblings)
     {
-        if (!m_componentCache.contains(entity))
+        for (uint32_t i = 0; i < m_pendingOrder.size(); ++i)
         {
-            return;
+            // 实体在最后一次事件的位置应用，也可能已经作为其他实体的依赖提前应用
+            const Entity entity = m_pendingOrder[i];
+            const PendingEvent* pending = m_pendingEvents.Find(entity);
+            if (pending && pending->m_order == i)
+            {
+                ApplyWithDependencies(entity, resolveSiblings);
+            }
         }
+        m_pendingOrder.clear();
+        m_pendingEvents.Clear();
 
-        const auto hier = context.Get<Hierarchy>(entity);
-        RemoveEntityInternal(hier);
-        
-        while(!m_updateFunctions.empty())
+        // 应用过程只修改缓存，最后统一写回仍然存在的Hierarchy组件，不会触发组件事件
+        for (Entity entity : m_touched)
         {
-            auto func = m_updateFunctions.front();
-            func();
-            m_updateFunctions.pop();
+            Hierarchy* component = GetComponent(entity);
+            const Hierarchy* cached = m_componentCache.Find(entity);
+            if (component && cached)
+            {
+                *component = *cached;
+            }
         }
-        
-        m_componentCache.erase(entity);
-        m_roots.erase(entity);
-        m_entities.erase(entity);
-        UpdateEntityTree();
+        m_touched.Clear();
+
+        FlushPendingUpdates();
+    }
+
+    void SceneManager::RecordEvent(Entity entity, bool destory)
+    {
+        // 同一实体的多次事件只应用一次，应用时读取组件的最终状态
+        PendingEvent& pending = m_pendingEvents[entity];
+        pending.m_order = static_cast<uint32_t>(m_pendingOrder.size());
+        pending.m_destory = destory;
+        pending.m_visited = false;
+        m_pendingOrder.push_back(entity);
+
+        if (!IsInBatch())
+        {
+            ApplyPendingEvents(false);
+        }
+    }
+
+    void SceneManager::OnComponentConstruct(WorldContext& context, Entity entity)
+    {
+        RecordEvent(entity, false);
+    }
+
+    void SceneManager::OnComponentUpdate(WorldContext& context, Entity entity)
+    {
+        RecordEvent(entity, false);
+    }
+
+    void SceneManager::OnComponentDestory(WorldContext& context, Entity entity)
+    {
+        RecordEvent(entity, true);
     }
 }
\ No newline at end of file
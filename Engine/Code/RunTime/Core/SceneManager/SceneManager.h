@@ -1,16 +1,20 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
 #include <EASTL/functional.h>
 #include <EASTL/unordered_set.h>
 #include <EASTL/set.h>
-#include <EASTL/queue.h>
 
 #include <ECS/ISystem.h>
 #include <ECS/Bus/ComponentEventBus.h>
 #include <ECS/WorldContext.h>
+#include <ECS/EntityMap.h>
 
 #include "IScene.h"
 #include "EntityHierarchy.h"
+#include "EntityDFSOrder.h"
 #include "Component/HierarchyComponent.h"
 
 namespace Spark
@@ -50,8 +54,17 @@ namespace Spark
         eastl::vector<Entity> GetChildren(Entity entity) const override;
         size_t GetDepth(Entity entity) const override;
         eastl::vector<eastl::pair<Entity, unsigned int>> GetEntityTree() const override;
+        eastl::span<const Entity> GetRootEntitiesView() const override;
+        eastl::span<const Entity> GetChildrenView(Entity entity) const override;
+        eastl::span<const eastl::pair<Entity, uint32_t>> GetEntityTreeView() const override;
+        eastl::span<const eastl::pair<Entity, uint32_t>> GetEntityTreeRange(size_t first, size_t count) const override;
+        eastl::span<const eastl::pair<Entity, uint32_t>> GetSubtreeView(Entity entity) const override;
         void SetParent(Entity entity, Entity parent, Entity prevSibling = NullEntity) override;
         void PatchEntityHierarchy(Entity entity, eastl::function<void(Entity)> func) override;
+        void BeginBatch() override;
+        void EndBatch() override;
+        bool IsInBatch() const override;
+        void Instantiate(const Prefab& prefab, size_t count, eastl::span<Entity> entities) override;
 
         // ComponentEventBus
         void OnComponentConstruct(WorldContext& context, Entity entity) override;
@@ -59,39 +72,92 @@ namespace Spark
         void OnComponentDestory(WorldContext& context, Entity entity) override;
     
     private:
-        /// @brief Update m_entityDFSTree according to m_roots and m_childrenMap
-        void UpdateEntityTree();
+        /// @brief Rebuild m_entityDFSTree from m_entityOrder if it is dirty
+        void UpdateEntityTree() const;
 
-        /// @brief Update m_childrenMap according to Hierarchy component of entity
-        /// @param entity 
-        void UpdateChildrenMap(Entity entity);
+        /// @brief Rebuild the children of the dirty parents in m_childrenMap if there are any, thread safe
+        void UpdateChildrenMap() const;
 
-        /// @brief Update m_roots according to Hierarchy component of entity
+        /// @brief Update m_roots according to the cached Hierarchy of entity
         void UpdateRoots(Entity entity);
 
-        /// @brief Remove entity hierarchy from the hierarchies, the functon will not trigger any Hierarchy component update event
-        ///        or update m_childrenMap and m_roots
-        /// @param hierarchy The Hierarchy component of the entity, the param is not a entity, because the entity has been updated or destoryed 
-        void RemoveEntityInternal(const Hierarchy& hierarchy);
+        /// @brief Record a Hierarchy event, it is applied at once outside a batch and when the outermost batch ends inside one
+        void RecordEvent(Entity entity, bool destory);
+
+        /// @brief Apply the recorded events in one pass, then write the changed hierarchies back to the components
+        /// @param resolveSiblings Take the position from parent and prevSibling, the sibling links of the components are stale in a batch
+        void ApplyPendingEvents(bool resolveSiblings);
+
+        /// @brief Apply the event of entity after the pending events of its parent and previous sibling
+        void ApplyWithDependencies(Entity entity, bool resolveSiblings);
 
-        /// @brief Add entity hierarchy to the hierarchies, the functon will not trigger any Hierarchy component update event
-        ///        or update m_childrenMap and m_roots
+        /// @brief Add, move or remove entity according to its Hierarchy component
+        void ApplyEvent(Entity entity, bool destory, bool resolveSiblings);
+
+        /// @brief Remove entity hierarchy from the hierarchies, the functon only changes the cached Hierarchy of other entities
+        ///        and will not trigger any Hierarchy component update event or update m_childrenMap and m_roots
+        /// @param entity
+        /// @param hierarchy The cached Hierarchy of the entity
+        void RemoveEntityInternal(Entity entity, const Hierarchy& hierarchy);
+
+        /// @brief Add entity hierarchy to the hierarchies, the functon only changes the cached Hierarchy
+        ///        and will not trigger any Hierarchy component update event or update m_childrenMap and m_roots
         /// @param entity 
-        void AddEntityInternal(Entity entity);
+        /// @param hierarchy The new Hierarchy of the entity, it must be valid
+        void AddEntityInternal(Entity entity, const Hierarchy& hierarchy);
 
-        bool Valid(const Hierarchy& hierarchy) const;
+        /// @brief Remove entity from the scene and all caches, its children rise to its parent
+        void RemoveFromScene(Entity entity);
+
+        /// @brief Insert entity into the sibling list described by hierarchy and cache the resolved Hierarchy
+        void LinkEntity(Entity entity, Hierarchy hierarchy);
 
-        void ForEachChild(const Hierarchy& hierarchy, eastl::function<void(Entity)> func);
+        /// @brief Take an entity out of its sibling list, its children are kept
+        void UnlinkEntity(const Hierarchy& hierarchy);
 
-        eastl::queue<eastl::function<void()>> m_updateFunctions;
+        void ResolveSiblings(Hierarchy& hierarchy) const;
+
+        /// @brief Cached Hierarchy of an entity in scene, the entity is written back to its component after the events are applied
+        Hierarchy& EditHierarchy(Entity entity);
+
+        Hierarchy* GetComponent(Entity entity);
+
+        /// @brief Update m_roots for entities recorded by hierarchy events, the children of their parents are rebuilt on the next read
+        void FlushPendingUpdates();
+
+        bool Valid(const Hierarchy& hierarchy) const;
+
+        struct PendingEvent
+        {
+            uint32_t m_order {0};        ///< Index of the last event of the entity in m_pendingOrder
+            bool     m_destory {false};
+            bool     m_visited {false};
+        };
+
+        // 批处理中记录的Hierarchy事件，EndBatch时统一校验和应用
+        EntityMap<PendingEvent> m_pendingEvents;
+        eastl::vector<Entity> m_pendingOrder;
+        eastl::vector<Entity> m_applyStack;
+        EntitySet m_touched;
+
+        // 应用事件时需要更新children map和roots的节点，children map在读取时才重建
+        mutable EntitySet m_dirtyParents;
+        eastl::vector<Entity> m_dirtyRoots;
+        uint32_t m_batchDepth {0};
 
         WorldContext& m_context;
 
         // 缓存信息
-        eastl::vector<eastl::pair<Entity, uint32_t>> m_entityDFSTree;
-        eastl::unordered_set<Entity>  m_entities;
-        eastl::unordered_set<Entity>  m_roots;
-        eastl::unordered_map<Entity, eastl::vector<Entity>> m_childrenMap;
-        eastl::unordered_map<Entity, Hierarchy> m_componentCache;
+        // m_entityOrder随Hierarchy事件增量维护，m_entityDFSTree只在读取时按需重建
+        EntityDFSOrder m_entityOrder;
+        mutable eastl::vector<eastl::pair<Entity, uint32_t>> m_entityDFSTree;
+        mutable EntityMap<uint32_t> m_entityTreeIndices;
+        mutable bool m_entityTreeDirty {false};
+        EntitySet  m_entities;
+        EntitySet  m_roots;
+        mutable EntityMap<eastl::vector<Entity>> m_childrenMap;
+        mutable std::mutex m_childrenMutex;
+        mutable std::atomic<bool> m_childrenDirty {false};
+        EntityMap<Hierarchy> m_componentCache;    ///< Hierarchy of the entities in scene, the components are synchronized from it
     };
 }
\ No newline at end of file
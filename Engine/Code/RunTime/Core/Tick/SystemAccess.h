@@ -0,0 +1,104 @@
+#pragma once
+
+#include <EASTL/vector.h>
+#include <EASTL/algorithm.h>
+
+#include <Reflection/RTTI.h>
+#include <ECS/WorldContext.h>
+
+namespace Spark
+{
+    /// @brief Components read and written by a tick handler, SystemScheduler runs handlers whose access does not
+    ///  conflict at the same time.
+    ///
+    /// A new access is exclusive: the handler conflicts with every other handler and runs on the calling thread.
+    /// Declaring any Read or Write makes it shared, a shared handler which does not touch any component
+    /// can declare Read<>().
+    /// Handlers running concurrently may only modify the components they write, and must not create or destroy entities.
+    class SystemAccess
+    {
+    public:
+        template<typename... Components>
+        SystemAccess& Read()
+        {
+            m_exclusive = false;
+            (Add<Components>(m_reads), ...);
+            return *this;
+        }
+
+        template<typename... Components>
+        SystemAccess& Write()
+        {
+            m_exclusive = false;
+            (Add<Components>(m_writes), ...);
+            return *this;
+        }
+
+        bool IsExclusive() const
+        {
+            return m_exclusive;
+        }
+
+        /// @brief Two accesses conflict if one of them is exclusive or writes a component the other one reads or writes
+        bool ConflictsWith(const SystemAccess& other) const
+        {
+            if (m_exclusive || other.m_exclusive)
+            {
+                return true;
+            }
+
+            return Intersects(m_writes, other.m_writes)
+                || Intersects(m_writes, other.m_reads)
+                || Intersects(m_reads, other.m_writes);
+        }
+
+        /// @brief Create the component storages in context, so concurrent handlers never insert a storage into the registry
+        void PrepareStorages(WorldContext& context) const
+        {
+            for (auto prepare : m_prepares)
+            {
+                prepare(context);
+            }
+        }
+
+        void Reset()
+        {
+            m_exclusive = true;
+            m_reads.clear();
+            m_writes.clear();
+            m_prepares.clear();
+        }
+
+    private:
+        using PrepareFunc = void (*)(WorldContext&);
+
+        template<typename Component>
+        void Add(eastl::vector<TypeIndex>& types)
+        {
+            const TypeIndex id = GetTypeIndex<Component>();
+            if (eastl::find(types.begin(), types.end(), id) == types.end())
+            {
+                types.push_back(id);
+                // 非const的GetView会创建组件存储
+                m_prepares.push_back([](WorldContext& context) { context.GetView<Component>(); });
+            }
+        }
+
+        static bool Intersects(const eastl::vector<TypeIndex>& lhs, const eastl::vector<TypeIndex>& rhs)
+        {
+            for (TypeIndex id : lhs)
+            {
+                if (eastl::find(rhs.begin(), rhs.end(), id) != rhs.end())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool                       m_exclusive {true};
+        eastl::vector<TypeIndex>   m_reads;
+        eastl::vector<TypeIndex>   m_writes;
+        eastl::vector<PrepareFunc> m_prepares;
+    };
+}
@@ -0,0 +1,158 @@
+#include "SystemScheduler.h"
+
+#include <EASTL/algorithm.h>
+
+#include <Service/Service.h>
+#include <Jobs/IJobSystem.h>
+
+namespace Spark
+{
+    void SystemScheduler::Initialize()
+    {
+    }
+
+    void SystemScheduler::ShutDown()
+    {
+        m_nodes.clear();
+        m_nodeCount = 0;
+    }
+
+    void SystemScheduler::Tick(WorldContext& context, float deltaTime)
+    {
+        // 只调度在context所属环境中连接的处理器
+        EBusEnvironment::Scope busScope(context.GetBusEnvironment());
+        IJobSystem* jobSystem = Service<IJobSystem>::Get();
+        if (m_config.m_mode == ScheduleMode::Serial || !jobSystem)
+        {
+            TickBus::Broadcast(&TickBus::Events::OnTick, context, deltaTime);
+            return;
+        }
+
+        m_context = &context;
+        m_deltaTime = deltaTime;
+        BuildGraph();
+        RunParallel(*jobSystem);
+        m_context = nullptr;
+    }
+
+    void SystemScheduler::BuildGraph()
+    {
+        m_handlers.clear();
+        TickBus::EnumerateHandlers([this](TickEvents* handler)
+        {
+            m_handlers.push_back(handler);
+            return true;
+        });
+
+        m_nodeCount = m_handlers.size();
+        if (m_nodes.size() < m_nodeCount)
+        {
+            m_nodes.resize(m_nodeCount);
+        }
+
+        for (size_t i = 0; i < m_nodeCount; ++i)
+        {
+            Node& node = m_nodes[i];
+            node.handler = m_handlers[i];
+            node.access.Reset();
+            node.handler->GetTickAccess(node.access);
+            node.predecessors.clear();
+
+            // 依赖名称来自ISystem::Request
+            node.system = dynamic_cast<const ISystem*>(node.handler);
+            node.requests.clear();
+            if (node.system)
+            {
+                node.name = node.system->GetName();
+                node.requests = node.system->Request();
+            }
+
+            // 组件存储只在主线程创建
+            if (!node.access.IsExclusive())
+            {
+                node.access.PrepareStorages(*m_context);
+            }
+
+            // 只连接到之前的节点，保证是无环图且与串行顺序一致
+            for (size_t j = 0; j < i; ++j)
+            {
+                if (DependsOn(node, m_nodes[j]))
+                {
+                    node.predecessors.push_back(static_cast<uint32_t>(j));
+                }
+            }
+        }
+    }
+
+    bool SystemScheduler::DependsOn(const Node& node, const Node& earlier) const
+    {
+        if (node.access.ConflictsWith(earlier.access))
+        {
+            return true;
+        }
+
+        if (!node.system || !earlier.system)
+        {
+            return false;
+        }
+
+        if (eastl::find(node.requests.begin(), node.requests.end(), earlier.name) != node.requests.end())
+        {
+            return true;
+        }
+
+        // 被依赖的系统排在后面时也不能同时执行，顺序仍由TickOrder决定
+        return eastl::find(earlier.requests.begin(), earlier.requests.end(), node.name) != earlier.requests.end();
+    }
+
+    void SystemScheduler::RunParallel(IJobSystem& jobSystem)
+    {
+        // 前驱节点的任务总是先创建，依赖在提交前添加
+        for (size_t i = 0; i < m_nodeCount; ++i)
+        {
+            Node& node = m_nodes[i];
+            if (node.access.IsExclusive())
+            {
+                node.job = jobSystem.CreateJob(JobFunc());
+                continue;
+            }
+
+            const uint32_t index = static_cast<uint32_t>(i);
+            node.job = jobSystem.CreateJob([this, index]() { Execute(index); });
+            for (uint32_t predecessor : node.predecessors)
+            {
+                jobSystem.AddDependency(node.job, m_nodes[predecessor].job);
+            }
+            jobSystem.Submit(node.job);
+        }
+
+        // 独占节点按tick顺序在调用线程执行，等待期间调用线程也执行队列中的任务
+        for (size_t i = 0; i < m_nodeCount; ++i)
+        {
+            Node& node = m_nodes[i];
+            if (!node.access.IsExclusive())
+            {
+                continue;
+            }
+
+            for (uint32_t predecessor : node.predecessors)
+            {
+                jobSystem.Wait(m_nodes[predecessor].job);
+            }
+            Execute(static_cast<uint32_t>(i));
+            jobSystem.Submit(node.job);
+        }
+
+        for (size_t i = 0; i < m_nodeCount; ++i)
+        {
+            jobSystem.Wait(m_nodes[i].job);
+            m_nodes[i].job.reset();
+        }
+    }
+
+    void SystemScheduler::Execute(uint32_t index)
+    {
+        EBusEnvironment::Scope busScope(m_context->GetBusEnvironment());
+        m_nodes[index].handler->OnTick(*m_context, m_deltaTime);
+    }
+}
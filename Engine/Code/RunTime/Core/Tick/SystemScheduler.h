@@ -0,0 +1,104 @@
+#pragma once
+
+#include <EASTL/vector.h>
+
+#include <ECS/ISystem.h>
+#include <ECS/WorldContext.h>
+#include <Jobs/Job.h>
+
+#include "TickBus.h"
+#include "SystemAccess.h"
+
+namespace Spark
+{
+    class IJobSystem;
+
+    enum class ScheduleMode
+    {
+        Serial,     ///< Call all handlers on the calling thread in tick order, the same as broadcasting TickBus
+        Parallel    ///< Run handlers without conflicting access concurrently as jobs of IJobSystem
+    };
+
+    struct SystemSchedulerConfig
+    {
+        ScheduleMode m_mode = ScheduleMode::Parallel;
+    };
+
+    /// @brief Tick all TickBus handlers, running independent handlers concurrently.
+    ///
+    /// Every frame the handlers are taken in tick order and a DAG is built from them: a handler depends on every
+    /// earlier handler whose SystemAccess conflicts with its own, and on the earlier handlers it requests
+    /// by ISystem::Request(). Only handlers without such a path between them run at the same time, so for handlers
+    /// which declare their access honestly the result is the same as in serial mode.
+    ///
+    /// Shared handlers are submitted to Service<IJobSystem> as jobs depending on the jobs of their predecessors,
+    /// exclusive handlers (the default) always run on the calling thread, which runs queued jobs while it waits.
+    /// Without IJobSystem the handlers are called serially.
+    /// Handlers must not connect or disconnect other tick handlers inside OnTick.
+    class SystemScheduler final : public ISystem
+    {
+    public:
+        SystemScheduler() = default;
+        explicit SystemScheduler(const SystemSchedulerConfig& config) : m_config(config) {}
+
+        // ISystem
+        void Initialize() override;
+        void ShutDown() override;
+        eastl::vector<HashString> Request() const override
+        {
+            return {"LogSystem"_hs, "JobSystem"_hs};
+        }
+
+        HashString GetName() const override
+        {
+            return "SystemScheduler"_hs;
+        }
+
+        /// @brief Tick all handlers of TickBus once
+        void Tick(WorldContext& context, float deltaTime);
+
+        /// @brief Takes effect from the next Tick
+        void SetMode(ScheduleMode mode)
+        {
+            m_config.m_mode = mode;
+        }
+
+        ScheduleMode GetMode() const
+        {
+            return m_config.m_mode;
+        }
+
+    private:
+        struct Node
+        {
+            TickEvents*               handler {nullptr};
+            const ISystem*            system {nullptr};     // 处理器同时是ISystem时有效
+            SystemAccess              access;
+            HashString                name;
+            eastl::vector<HashString> requests;
+            eastl::vector<uint32_t>   predecessors;
+            JobHandle                 job;      // 独占节点的任务为空任务，在调用线程执行完后提交
+        };
+
+        /// @brief Collect handlers and build the DAG of this frame
+        void BuildGraph();
+
+        /// @brief Whether the node must run after the earlier node
+        bool DependsOn(const Node& node, const Node& earlier) const;
+
+        void RunParallel(IJobSystem& jobSystem);
+
+        /// @brief Call OnTick of the node in the bus environment of the context
+        void Execute(uint32_t index);
+
+        SystemSchedulerConfig m_config {};
+
+        // 节点数组和各数组容量逐帧复用
+        eastl::vector<Node>        m_nodes;
+        size_t                     m_nodeCount {0};
+        eastl::vector<TickEvents*> m_handlers;
+
+        WorldContext* m_context {nullptr};
+        float         m_deltaTime {0.f};
+    };
+}
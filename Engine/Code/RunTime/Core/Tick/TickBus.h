@@ -6,6 +6,7 @@
 #include <ECS/WorldContext.h>
 
 #include "TickOrder.h"
+#include "SystemAccess.h"
 
 namespace Spark
 {
@@ -23,6 +24,17 @@ namespace Spark
         {
             return GetTickOrder() < other->GetTickOrder();
         }
+
+        // 连接时缓存GetTickOrder，插入时不再调用虚函数
+        using BusHandlerOrderKey = unsigned int;
+        static BusHandlerOrderKey GetHandlerOrderKey(const TickEvents* handler)
+        {
+            return handler->GetTickOrder();
+        }
+
+        // 每个世界的系统连接在自己的EBusEnvironment中
+        template <typename Context>
+        using StoragePolicy = EBusEnvironmentStoragePolicy<Context>;
     public:
         TickEvents() = default;
         virtual ~TickEvents() = default;
@@ -32,6 +44,10 @@ namespace Spark
         {
             return static_cast<unsigned int>(TickOrder::TICK_DEFAULT);
         }
+
+        /// @brief Declare the components used in OnTick, see SystemAccess.
+        ///  The default access is exclusive, the handler runs on the calling thread and never together with others.
+        virtual void GetTickAccess([[maybe_unused]] SystemAccess& access) const {}
     };
 
     using TickBus = EBus<TickEvents>;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <Math/Vector3.h>
+#include <Math/Vector4.h>
+#include <Math/Quaternion.h>
+#include <Math/Matrix4x4.h>
+
+namespace Spark
+{
+    /// @brief Transform relative to the parent entity in the scene hierarchy (or to the world if the entity has no parent).
+    ///
+    /// Only AddOrRepalce or Repalce on LocalTransform is observed by the TransformSystem, modifying the component
+    /// through a reference returned by Get will not update the WorldTransform.
+    struct LocalTransform
+    {
+        Math::Vector3    position {Math::Vector3Const::ZERO};
+        Math::Quaternion rotation {Math::QuaternionConst::IDENTITY};
+        Math::Vector3    scale {Math::Vector3Const::ONE};
+
+        Math::Matrix4X4 ToMatrix() const
+        {
+            Math::Matrix4X4 matrix = glm::mat4_cast(rotation);
+            matrix[0] *= scale.x;
+            matrix[1] *= scale.y;
+            matrix[2] *= scale.z;
+            matrix[3] = Math::Vector4(position, 1.0f);
+            return matrix;
+        }
+    };
+
+    /// @brief Transform relative to the world, it is computed by the TransformSystem every frame
+    ///  and should be treated as read-only.
+    struct WorldTransform
+    {
+        Math::Matrix4X4 matrix {Math::Matrix4X4Const::IDENTITY};
+    };
+}
@@ -0,0 +1,451 @@
+#include "TransformSystem.h"
+
+#include <EASTL/algorithm.h>
+
+#include <Log/SpdLogSystem.h>
+#include <Service/Service.h>
+#include <Jobs/IJobSystem.h>
+#include <SceneManager/IScene.h>
+
+namespace Spark
+{
+    void TransformSystem::Initialize()
+    {
+        m_localObserver.Connect(m_context);
+        m_hierarchyObserver.Connect(m_context);
+        m_worldObserver.Connect(m_context);
+        TickBus::Handler::BusConnect();
+    }
+
+    void TransformSystem::ShutDown()
+    {
+        TickBus::Handler::BusDisconnect();
+        m_localObserver.Disconnect();
+        m_hierarchyObserver.Disconnect();
+        m_worldObserver.Disconnect();
+
+        m_entities.clear();
+        m_parents.clear();
+        m_locals.clear();
+        m_worlds.clear();
+        m_dirty.clear();
+        m_ranges.clear();
+        m_rangeOf.clear();
+        m_rangeDirty.clear();
+        m_worldComponents.clear();
+        m_indices.Clear();
+        m_emptySlots = 0;
+        m_pending.Clear();
+        m_moved.Clear();
+        m_newWorlds.clear();
+        m_layoutDirty = true;
+        m_worldsUnsorted = true;
+    }
+
+    void TransformSystem::OnTick(WorldContext& context, float deltaTime)
+    {
+        UpdateTransforms();
+    }
+
+    void TransformSystem::CollectChanges()
+    {
+        for (Entity entity : m_hierarchyObserver.GetConstructed())
+        {
+            m_moved.Insert(entity);
+        }
+        for (Entity entity : m_hierarchyObserver.GetUpdated())
+        {
+            m_moved.Insert(entity);
+        }
+        for (Entity entity : m_hierarchyObserver.GetDestoryed())
+        {
+            m_moved.Insert(entity);
+        }
+        m_hierarchyObserver.Clear();
+
+        for (Entity entity : m_localObserver.GetConstructed())
+        {
+            if (m_context.Valid(entity) && !m_context.Has<WorldTransform>(entity))
+            {
+                m_newWorlds.push_back(entity);
+            }
+            m_pending.Insert(entity);
+        }
+
+        // 移除LocalTransform的实体按单位矩阵处理
+        for (Entity entity : m_localObserver.GetUpdated())
+        {
+            m_pending.Insert(entity);
+        }
+        for (Entity entity : m_localObserver.GetDestoryed())
+        {
+            m_pending.Insert(entity);
+        }
+        m_localObserver.Clear();
+
+        // 组件的增删会移动存储中的其他组件，只修改值不影响缓存的指针
+        if (!m_worldObserver.GetConstructed().empty() || !m_worldObserver.GetDestoryed().empty())
+        {
+            m_worldsUnsorted = true;
+        }
+        m_worldObserver.Clear();
+    }
+
+    void TransformSystem::UpdateTransforms()
+    {
+        CollectChanges();
+        if (m_layoutDirty || !m_moved.Empty())
+        {
+            IScene* scene = Service<IScene>::Get();
+            if (!scene)
+            {
+                LOG_ERROR("[TransformSystem] UpdateTransforms: There is no scene");
+            }
+            else if (m_layoutDirty)
+            {
+                RebuildLayout(*scene);
+            }
+            else
+            {
+                SpliceLayout(*scene);
+            }
+            m_moved.Clear();
+        }
+        if (m_worldsUnsorted)
+        {
+            SortWorldComponents();
+        }
+        ApplyPendingChanges();
+        PropagateDirtyRanges();
+
+        // 添加组件是结构性修改，通过命令缓冲推迟到同步点，组件带上本帧计算的结果
+        if (!m_newWorlds.empty())
+        {
+            CommandBuffer& commands = m_context.GetCommandBuffer();
+            for (Entity entity : m_newWorlds)
+            {
+                if (const uint32_t* index = m_indices.Find(entity))
+                {
+                    commands.Add<WorldTransform>(entity, m_worlds[*index]);
+                }
+                else if (const LocalTransform* local = m_context.TryGet<LocalTransform>(entity))
+                {
+                    commands.Add<WorldTransform>(entity, local->ToMatrix());
+                }
+            }
+            m_newWorlds.clear();
+        }
+    }
+
+    void TransformSystem::PropagateDirtyRanges()
+    {
+        eastl::vector<uint32_t> dirtyRanges;
+        size_t total = 0;
+        for (uint32_t range = 0; range < m_rangeDirty.size(); ++range)
+        {
+            if (m_rangeDirty[range])
+            {
+                dirtyRanges.push_back(range);
+                total += m_ranges[range].end - m_ranges[range].begin;
+                m_rangeDirty[range] = 0;
+            }
+        }
+
+        if (dirtyRanges.empty())
+        {
+            return;
+        }
+
+        IJobSystem* jobSystem = Service<IJobSystem>::Get();
+        if (!jobSystem || total < MinParallelEntities)
+        {
+            Propagate(dirtyRanges.begin(), dirtyRanges.end());
+            return;
+        }
+
+        // 以根节点子树为单位拆分，子树大小不一由任务系统动态均衡
+        const uint32_t* ranges = dirtyRanges.data();
+        jobSystem->ParallelFor(0, dirtyRanges.size(), [this, ranges](size_t first, size_t last)
+        {
+            Propagate(ranges + first, ranges + last);
+        });
+    }
+
+    void TransformSystem::SortWorldComponents()
+    {
+        // 空区间中留有已替换的实体，只按存活节点排序
+        eastl::vector<Entity> order;
+        order.reserve(m_entities.size() - m_emptySlots);
+        for (const RootRange& range : m_ranges)
+        {
+            order.insert(order.end(), m_entities.begin() + range.begin, m_entities.begin() + range.end);
+        }
+
+        auto worldView = m_context.GetView<WorldTransform>();
+        auto& storage = *worldView.storage();
+        storage.sort_as(order.begin(), order.end());
+
+        m_worldComponents.assign(m_entities.size(), nullptr);
+        for (const RootRange& range : m_ranges)
+        {
+            FindWorldComponents(range.begin, range.end);
+        }
+        m_worldsUnsorted = false;
+    }
+
+    void TransformSystem::FindWorldComponents(uint32_t first, uint32_t last)
+    {
+        auto worldView = m_context.GetView<WorldTransform>();
+        for (uint32_t index = first; index < last; ++index)
+        {
+            const Entity entity = m_entities[index];
+            m_worldComponents[index] = worldView.contains(entity) ? &worldView.get<WorldTransform>(entity) : nullptr;
+        }
+    }
+
+    void TransformSystem::RebuildLayout(const IScene& scene)
+    {
+        EntityMap<uint32_t> oldIndices;
+        eastl::vector<Entity> oldEntities;
+        eastl::vector<uint32_t> oldParents;
+        eastl::vector<Math::Matrix4X4> oldLocals;
+        eastl::vector<Math::Matrix4X4> oldWorlds;
+        eastl::swap(oldIndices, m_indices);
+        oldEntities.swap(m_entities);
+        oldParents.swap(m_parents);
+        oldLocals.swap(m_locals);
+        oldWorlds.swap(m_worlds);
+
+        // 预留被替换子树追加所需的空间，避免拼接时整体重新分配
+        const size_t size = scene.GetEntityCount() + scene.GetEntityCount() / 2;
+        m_entities.reserve(size);
+        m_parents.reserve(size);
+        m_locals.reserve(size);
+        m_worlds.reserve(size);
+        m_dirty.clear();
+        m_dirty.reserve(size);
+        m_rangeOf.clear();
+        m_rangeOf.reserve(size);
+        m_ranges.clear();
+        m_rangeDirty.clear();
+        m_emptySlots = 0;
+        m_worldsUnsorted = true;
+
+        const PreviousLayout previous {oldIndices, oldEntities, oldParents, oldLocals, oldWorlds};
+        auto localView = m_context.GetView<LocalTransform>();
+        for (Entity root : scene.GetRootEntitiesView())
+        {
+            AppendSubtree(scene, root, previous, localView);
+        }
+
+        m_indices.Reserve(m_entities.size());
+        for (uint32_t index = 0; index < m_entities.size(); ++index)
+        {
+            m_indices.InsertOrAssign(m_entities[index], index);
+        }
+        m_layoutDirty = false;
+
+        // 离开场景的实体不再有父节点，需要按根节点重新计算
+        for (Entity entity : oldIndices.Entities())
+        {
+            if (!m_indices.Contains(entity))
+            {
+                m_pending.Insert(entity);
+            }
+        }
+    }
+
+    void TransformSystem::SpliceLayout(const IScene& scene)
+    {
+        // 找出受影响的旧子树和新的根节点：旧子树的根节点可能已经属于另一棵树，新的根节点也可能有自己的旧子树
+        eastl::vector<uint32_t> oldRanges;
+        eastl::vector<uint8_t> replaced(m_ranges.size(), 0);
+        EntitySet roots;
+        eastl::vector<Entity> work(m_moved.Entities().begin(), m_moved.Entities().end());
+        size_t replacedSlots = 0;
+        while (!work.empty())
+        {
+            const Entity entity = work.back();
+            work.pop_back();
+
+            if (const uint32_t* index = m_indices.Find(entity))
+            {
+                const uint32_t range = m_rangeOf[*index];
+                if (!replaced[range])
+                {
+                    replaced[range] = 1;
+                    oldRanges.push_back(range);
+                    replacedSlots += m_ranges[range].end - m_ranges[range].begin;
+                    work.push_back(m_entities[m_ranges[range].begin]);
+                }
+            }
+
+            if (scene.Contain(entity))
+            {
+                const Entity root = scene.GetEntityRoot(entity);
+                if (roots.Insert(root).second)
+                {
+                    work.push_back(root);
+                }
+            }
+        }
+
+        // 空位超过存活节点的一半时整体重建，此时追加的空间也将用完
+        if ((m_emptySlots + replacedSlots) * 2 > m_entities.size() - m_emptySlots)
+        {
+            RebuildLayout(scene);
+            return;
+        }
+
+        // 旧子树的数据在追加期间保持不变
+        const uint32_t first = static_cast<uint32_t>(m_entities.size());
+        const PreviousLayout previous {m_indices, m_entities, m_parents, m_locals, m_worlds};
+        auto localView = m_context.GetView<LocalTransform>();
+        for (Entity root : roots)
+        {
+            AppendSubtree(scene, root, previous, localView);
+        }
+
+        for (uint32_t index = first; index < m_entities.size(); ++index)
+        {
+            m_indices.InsertOrAssign(m_entities[index], index);
+        }
+
+        // 追加的节点不重新排序存储，整体重建时再恢复顺序
+        m_worldComponents.resize(m_entities.size(), nullptr);
+        if (!m_worldsUnsorted)
+        {
+            FindWorldComponents(first, static_cast<uint32_t>(m_entities.size()));
+        }
+
+        for (uint32_t range : oldRanges)
+        {
+            RootRange& oldRange = m_ranges[range];
+            for (uint32_t index = oldRange.begin; index < oldRange.end; ++index)
+            {
+                // 没有出现在新子树中的实体已经离开场景
+                const Entity entity = m_entities[index];
+                const uint32_t* current = m_indices.Find(entity);
+                if (current && *current == index)
+                {
+                    m_indices.Erase(entity);
+                    m_pending.Insert(entity);
+                }
+            }
+            m_emptySlots += oldRange.end - oldRange.begin;
+            oldRange.end = oldRange.begin;
+            m_rangeDirty[range] = 0;
+        }
+    }
+
+    void TransformSystem::AppendSubtree(const IScene& scene, Entity root, const PreviousLayout& previous, LocalView& localView)
+    {
+        const uint32_t range = static_cast<uint32_t>(m_ranges.size());
+        const uint32_t begin = static_cast<uint32_t>(m_entities.size());
+        bool rangeDirty = false;
+
+        auto append = [&](Entity entity, uint32_t parent)
+        {
+            const Entity parentEntity = parent == NoParent ? NullEntity : m_entities[parent];
+            const uint32_t* oldIndex = previous.indices.Find(entity);
+            const uint32_t oldParent = oldIndex ? previous.parents[*oldIndex] : NoParent;
+            const Entity oldParentEntity = oldParent == NoParent ? NullEntity : previous.entities[oldParent];
+
+            // 父节点不变时世界矩阵不变，沿用旧数据，先拷贝出来以免追加时数组重新分配
+            Math::Matrix4X4 local;
+            Math::Matrix4X4 world;
+            uint8_t dirty = 0;
+            if (oldIndex && oldParentEntity == parentEntity)
+            {
+                local = previous.locals[*oldIndex];
+                world = previous.worlds[*oldIndex];
+            }
+            else
+            {
+                local = localView.contains(entity) ? localView.get<LocalTransform>(entity).ToMatrix()
+                                                   : Math::Matrix4X4Const::IDENTITY;
+                world = local;
+                dirty = 1;
+                rangeDirty = true;
+            }
+
+            m_entities.push_back(entity);
+            m_parents.push_back(parent);
+            m_locals.push_back(local);
+            m_worlds.push_back(world);
+            m_dirty.push_back(dirty);
+            m_rangeOf.push_back(range);
+        };
+
+        // 按层展开子树，父节点总在子节点之前
+        append(root, NoParent);
+        for (uint32_t index = begin; index < m_entities.size(); ++index)
+        {
+            for (Entity child : scene.GetChildrenView(m_entities[index]))
+            {
+                append(child, index);
+            }
+        }
+
+        m_ranges.push_back({begin, static_cast<uint32_t>(m_entities.size())});
+        m_rangeDirty.push_back(rangeDirty);
+    }
+
+    void TransformSystem::ApplyPendingChanges()
+    {
+        for (Entity entity : m_pending)
+        {
+            if (!m_context.Valid(entity))
+            {
+                continue;
+            }
+
+            const LocalTransform* local = m_context.TryGet<LocalTransform>(entity);
+            const Math::Matrix4X4 matrix = local ? local->ToMatrix() : Math::Matrix4X4Const::IDENTITY;
+
+            if (const uint32_t* index = m_indices.Find(entity))
+            {
+                m_locals[*index] = matrix;
+                m_dirty[*index] = 1;
+                m_rangeDirty[m_rangeOf[*index]] = 1;
+            }
+            else if (WorldTransform* world = m_context.TryGet<WorldTransform>(entity))
+            {
+                // 不在场景中的实体没有父节点
+                world->matrix = matrix;
+            }
+        }
+        m_pending.Clear();
+    }
+
+    void TransformSystem::Propagate(const uint32_t* firstRange, const uint32_t* lastRange)
+    {
+        for (const uint32_t* range = firstRange; range != lastRange; ++range)
+        {
+            const uint32_t begin = m_ranges[*range].begin;
+            const uint32_t end = m_ranges[*range].end;
+            for (uint32_t index = begin; index < end; ++index)
+            {
+                const uint32_t parent = m_parents[index];
+                if (parent != NoParent && m_dirty[parent])
+                {
+                    m_dirty[index] = 1;
+                }
+
+                if (!m_dirty[index])
+                {
+                    continue;
+                }
+
+                m_worlds[index] = parent == NoParent ? m_locals[index] : m_worlds[parent] * m_locals[index];
+
+                if (WorldTransform* world = m_worldComponents[index])
+                {
+                    world->matrix = m_worlds[index];
+                }
+            }
+
+            eastl::fill(m_dirty.begin() + begin, m_dirty.begin() + end, uint8_t(0));
+        }
+    }
+}
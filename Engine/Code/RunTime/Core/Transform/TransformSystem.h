@@ -0,0 +1,154 @@
+#pragma once
+
+#include <EASTL/vector.h>
+
+#include <ECS/ISystem.h>
+#include <ECS/WorldContext.h>
+#include <ECS/EntityMap.h>
+#include <ECS/ComponentObserver.h>
+#include <SceneManager/Component/HierarchyComponent.h>
+#include <Tick/TickBus.h>
+#include <Math/Matrix4x4.h>
+
+#include "Component/TransformComponent.h"
+
+namespace Spark
+{
+    class IScene;
+
+    /// @brief Compute WorldTransform from LocalTransform along the scene hierarchy.
+    ///
+    /// Transforms of the entities in the scene are kept as structure-of-arrays, every root subtree is a contiguous range
+    /// in which a parent is always placed before its children.
+    /// Only entities whose LocalTransform has changed, or whose ancestor has changed, are recomputed,
+    /// root subtrees that do not contain any change are skipped, and the dirty subtrees are processed by
+    /// IJobSystem::ParallelFor when there is enough work.
+    ///
+    /// When the hierarchy changes only the root subtrees containing the changed entities are rebuilt: they are appended
+    /// at the end of the arrays and their old ranges are left empty, the arrays are compacted by a full rebuild once
+    /// the empty slots outnumber half of the entities. Entities whose parent has not changed keep their world transform.
+    ///
+    /// The WorldTransform storage is sorted in the order of the arrays whenever it or the layout is rebuilt, so the
+    /// results are written through cached component pointers in memory order instead of by entity lookups.
+    ///
+    /// An entity in the scene without LocalTransform passes the world transform of its parent to its children.
+    /// An entity with LocalTransform which is not in the scene is treated as a root.
+    class TransformSystem final : public ISystem,
+                                  public TickBus::Handler
+    {
+    public:
+        TransformSystem(WorldContext& context) : m_context(context) {}
+
+        // ISystem
+        void Initialize() override;
+        void ShutDown() override;
+        eastl::vector<HashString> Request() const override
+        {
+            return {"LogSystem"_hs, "SceneManager"_hs};
+        }
+
+        HashString GetName() const override
+        {
+            return "TransformSystem"_hs;
+        }
+
+        // TickBus
+        void OnTick(WorldContext& context, float deltaTime) override;
+
+        inline unsigned int GetTickOrder() const override
+        {
+            return static_cast<unsigned int>(TickOrder::TICK_PRE_RENDER);
+        }
+
+        void GetTickAccess(SystemAccess& access) const override
+        {
+            // 场景只通过不会延迟重建的接口读取，缺少的WorldTransform通过命令缓冲添加
+            access.Read<LocalTransform, Hierarchy>().Write<WorldTransform>();
+        }
+
+        /// @brief Compute all pending WorldTransform changes immediately, OnTick calls it once per frame.
+        ///  WorldTransform of an entity which has just got LocalTransform is added through the command buffer
+        ///  of the calling thread, it appears at the next WorldContext::PlaybackCommands.
+        void UpdateTransforms();
+
+    private:
+        static constexpr uint32_t NoParent = ~uint32_t(0);
+
+        using LocalView = decltype(eastl::declval<WorldContext&>().GetView<LocalTransform>());
+
+        struct RootRange
+        {
+            uint32_t begin {0};
+            uint32_t end {0};
+        };
+
+        // 重建前的数据，父节点不变的实体沿用其中的矩阵
+        struct PreviousLayout
+        {
+            const EntityMap<uint32_t>&            indices;
+            const eastl::vector<Entity>&          entities;
+            const eastl::vector<uint32_t>&        parents;
+            const eastl::vector<Math::Matrix4X4>& locals;
+            const eastl::vector<Math::Matrix4X4>& worlds;
+        };
+
+        // 少于该数量的节点不值得并行计算
+        static constexpr size_t MinParallelEntities = 16 * 1024;
+
+        /// @brief Rebuild the arrays from all root subtrees of the scene
+        void RebuildLayout(const IScene& scene);
+
+        /// @brief Replace the root subtrees containing the entities whose Hierarchy has changed since last update
+        void SpliceLayout(const IScene& scene);
+
+        /// @brief Append the subtree of a root entity as a new root range, only new and reparented entities are marked dirty
+        void AppendSubtree(const IScene& scene, Entity root, const PreviousLayout& previous, LocalView& localView);
+
+        /// @brief Sort the WorldTransform storage in the order of the live nodes and cache the component of every node
+        void SortWorldComponents();
+
+        /// @brief Cache the WorldTransform component of the nodes [first, last) without reordering the storage
+        void FindWorldComponents(uint32_t first, uint32_t last);
+
+        /// @brief Collect changes recorded by the observers since last update
+        void CollectChanges();
+
+        /// @brief Reload LocalTransform of the entities changed since last update
+        void ApplyPendingChanges();
+
+        /// @brief Compute world transforms of all dirty root ranges, in parallel if there is enough work
+        void PropagateDirtyRanges();
+
+        /// @brief Compute world transforms of the dirty entities in the root ranges [firstRange, lastRange)
+        void Propagate(const uint32_t* firstRange, const uint32_t* lastRange);
+
+        WorldContext& m_context;
+
+        // 按DFS序存储的SoA数据
+        eastl::vector<Entity>          m_entities;
+        eastl::vector<uint32_t>        m_parents;
+        eastl::vector<Math::Matrix4X4> m_locals;
+        eastl::vector<Math::Matrix4X4> m_worlds;
+        eastl::vector<uint8_t>         m_dirty;
+        eastl::vector<RootRange>       m_ranges;       // 根节点子树的位置，被替换的子树留下空区间
+        eastl::vector<uint32_t>        m_rangeOf;      // 每个节点所在的根节点子树
+        eastl::vector<uint8_t>         m_rangeDirty;
+        eastl::vector<WorldTransform*> m_worldComponents; // 每个节点的WorldTransform组件，没有组件时为空
+        EntityMap<uint32_t>            m_indices;
+        size_t                         m_emptySlots {0};
+
+        ComponentObserver<LocalTransform> m_localObserver;
+        ComponentObserver<Hierarchy>      m_hierarchyObserver;
+        ComponentObserver<WorldTransform> m_worldObserver;
+
+        // 上次更新后LocalTransform改变的实体
+        EntitySet m_pending;
+        // 上次更新后Hierarchy改变的实体
+        EntitySet m_moved;
+        // 等待添加WorldTransform的实体
+        eastl::vector<Entity> m_newWorlds;
+        bool      m_layoutDirty {true};
+        // WorldTransform存储增删过组件或布局整体重建过，需要重新排序
+        bool      m_worldsUnsorted {true};
+    };
+}
@@ -3,6 +3,7 @@
 
 #include <Tick/TickBus.h>
 #include <ECS/WorldContext.h>
+#include <CoreComponents/Tags.h>
 #include <Reflection/TypeRegistry.h>
 #include <Reflect.h>
 
@@ -13,16 +14,27 @@ namespace Spark
         TypeRegistry::Register(Spark::Reflect);
         TypeRegistry::RegisterAll();
 
+        m_worldContext.RegisterTags<DeadTag, ActiveTag, SelectTag>();
+
         LogConfig logConfig{};
         logConfig.m_showTimeStamp = true;
         m_logSystem = eastl::make_unique<SpdLogSystem>(logConfig);
 
+        m_jobSystem = eastl::make_unique<JobSystem>();
+        m_jobSystem->Initialize();
+
+        m_systemScheduler = eastl::make_unique<SystemScheduler>();
+        m_systemScheduler->Initialize();
+
         m_entityReaper = eastl::make_unique<EntityReaper>();
         m_entityReaper->Initialize();
 
         m_sceneManager = eastl::make_unique<SceneManager>(m_worldContext);
         m_sceneManager->Initialize();
 
+        m_transformSystem = eastl::make_unique<TransformSystem>(m_worldContext);
+        m_transformSystem->Initialize();
+
         m_inputSystem = eastl::make_unique<Input::InputSystem>();
         m_inputSystem->Initialize();
 
@@ -34,8 +46,11 @@ namespace Spark
     {
         m_renderSystem->ShutDown();
         m_inputSystem->ShutDown();
+        m_transformSystem->ShutDown();
         m_sceneManager->ShutDown();
         m_entityReaper->ShutDown();
+        m_systemScheduler->ShutDown();
+        m_jobSystem->ShutDown();
     }
 
     void SparkEngine::Run(eastl::function<bool()> shouldQuit)
@@ -43,7 +58,11 @@ namespace Spark
         while (!shouldQuit())
         {
             float deltaTime = CalculDeltaTime();
-            TickBus::Broadcast(&TickBus::Events::OnTick, m_worldContext, deltaTime);
+            m_systemScheduler->Tick(m_worldContext, deltaTime);
+            // 回放的修改属于下一帧，使下一帧的Changed和Added过滤器能看到它们
+            m_worldContext.AdvanceFrame();
+            // 同步点：应用各线程记录的结构性修改
+            m_worldContext.PlaybackCommands();
         }
     }
 
@@ -7,7 +7,10 @@
 #include <ECS/WorldContext.h>
 #include <Log/SpdLogSystem.h>
 #include <SceneManager/SceneManager.h>
+#include <Transform/TransformSystem.h>
 #include <EntityReaper/EntityReaper.h>
+#include <Tick/SystemScheduler.h>
+#include <Jobs/JobSystem.h>
 #include <Feature/Render/RenderSystem.h>
 #include <Feature/Input/InputSystem.h>
 
@@ -46,6 +49,9 @@ namespace Spark
         eastl::unique_ptr<SpdLogSystem>                m_logSystem;
         eastl::unique_ptr<Input::InputSystem>          m_inputSystem;
         eastl::unique_ptr<SceneManager>                m_sceneManager;
+        eastl::unique_ptr<TransformSystem>             m_transformSystem;
         eastl::unique_ptr<EntityReaper>                m_entityReaper;
+        eastl::unique_ptr<SystemScheduler>             m_systemScheduler;
+        eastl::unique_ptr<JobSystem>                   m_jobSystem;
     };
 }
\ No newline at end of file
@@ -14,6 +14,9 @@ namespace Spark::RHI
         static constexpr EBusAddressPolicy AddressPolicy = EBusAddressPolicy::Single;
 
         using MutexType = std::recursive_mutex;
+
+        // 帧事件在多个线程上派发，派发时不加锁
+        static constexpr bool SnapshotDispatch = true;
     public:
         virtual void OnFrameBegin() {}
 
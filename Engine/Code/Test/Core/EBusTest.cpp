@@ -4,11 +4,15 @@
 #include <EASTL/unique_ptr.h>
 #include <EASTL/string_view.h>
 #include <EASTL/fixed_vector.h>
+#include <EASTL/unordered_map.h>
 #include <mutex>
 #include <thread>
 #include <random>
+#include <chrono>
+#include <iostream>
 
 #include <EBus/EBus.h>
+#include <EBus/EBusEnvironment.h>
 #include <EBus/Result.h>
 #include <Log/SpdLogSystem.h>
 
@@ -124,6 +128,190 @@ TEST(EBusTest, IdTest)
     EXPECT_FALSE(TestIdBus::HasHandlers());
 }
 
+class FlatIdTraits: public EBusTraits
+{
+public:
+    static const EBusHandlerPolicy HandlerPolicy = EBusHandlerPolicy::Multiple;
+    static const EBusAddressPolicy AddressPolicy = EBusAddressPolicy::ById;
+    static constexpr bool FlatAddressStorage = true;
+
+    using BusIdType = uint32_t;
+};
+
+using FlatIdBus = EBus<TestIdInterface, FlatIdTraits>;
+
+class AddressStorageHandler: public FlatIdBus::Handler
+{
+public:
+    void OnEvent() override
+    {
+        m_callEvents++;
+        if (m_disconnect)
+        {
+            m_disconnect->BusDisconnect();
+        }
+    }
+
+public:
+    uint32_t m_callEvents {0};
+    AddressStorageHandler* m_disconnect {nullptr};
+};
+
+TEST(EBusTest, FlatAddressStorageTest)
+{
+    static constexpr uint32_t addressCount = 10000;
+
+    // 扩容后BusPtr引用的HandlerHolder仍然有效
+    FlatIdBus::BusPtr ptr;
+    FlatIdBus::Bind(ptr, 0);
+    eastl::vector<AddressStorageHandler> handlers(addressCount);
+    for (uint32_t id = 0; id < addressCount; ++id)
+    {
+        handlers[id].BusConnect(id);
+    }
+    EXPECT_EQ(FlatIdBus::GetTotalNumOfEventHandlers(), addressCount);
+
+    FlatIdBus::Event(ptr, &FlatIdBus::Events::OnEvent);
+    EXPECT_EQ(handlers[0].m_callEvents, 1);
+    for (uint32_t id = 0; id < addressCount; ++id)
+    {
+        FlatIdBus::Event(id, &FlatIdBus::Events::OnEvent);
+    }
+    EXPECT_EQ(handlers[0].m_callEvents, 2);
+    EXPECT_EQ(handlers[addressCount - 1].m_callEvents, 1);
+
+    // 删除留下的墓碑不影响查找
+    for (uint32_t id = 1; id < addressCount; id += 2)
+    {
+        handlers[id].BusDisconnect();
+    }
+    for (uint32_t id = 0; id < addressCount; ++id)
+    {
+        EXPECT_EQ(FlatIdBus::HasHandlers(id), id % 2 == 0);
+    }
+    for (uint32_t id = 1; id < addressCount; id += 2)
+    {
+        handlers[id].BusConnect(id);
+    }
+    EXPECT_EQ(FlatIdBus::GetTotalNumOfEventHandlers(), addressCount);
+
+    // 广播中断开另一个地址
+    for (uint32_t id = 0; id < addressCount; id += 2)
+    {
+        handlers[id].m_disconnect = &handlers[id + 1];
+    }
+    for (auto& handler : handlers)
+    {
+        handler.m_callEvents = 0;
+    }
+    FlatIdBus::Broadcast(&FlatIdBus::Events::OnEvent);
+    for (uint32_t id = 0; id < addressCount; id += 2)
+    {
+        EXPECT_EQ(handlers[id].m_callEvents, 1);
+        EXPECT_LE(handlers[id + 1].m_callEvents, 1);
+    }
+    EXPECT_EQ(FlatIdBus::GetTotalNumOfEventHandlers(), addressCount / 2);
+    EXPECT_FALSE(FlatIdBus::HasHandlers(1));
+
+    for (auto& handler : handlers)
+    {
+        handler.BusDisconnect();
+    }
+    EXPECT_FALSE(FlatIdBus::HasHandlers());
+    ptr = nullptr;
+}
+
+class FlatIdBusHandler: public FlatIdBus::Handler
+{
+    void OnEvent() override
+    {
+        m_callEvents++;
+    }
+public:
+   uint32_t m_callEvents {0};
+};
+
+// 计时对比，不作为单元测试运行，使用--gtest_also_run_disabled_tests手动运行
+TEST(EBusTest, DISABLED_AddressLookupBenchmark)
+{
+    for (uint32_t addressCount : {10u, 1000u, 100000u})
+    {
+        eastl::vector<TestIdBusHandler> mapHandlers(addressCount);
+        eastl::vector<FlatIdBusHandler> flatHandlers(addressCount);
+        eastl::vector<uint32_t> ids(addressCount);
+        for (uint32_t i = 0; i < addressCount; ++i)
+        {
+            // 分散的id，模拟TypeId
+            ids[i] = i * 2654435761u;
+            mapHandlers[i].BusConnect(ids[i]);
+            flatHandlers[i].BusConnect(ids[i]);
+        }
+
+        // 同样的数据分别用两种容器查找
+        eastl::unordered_map<uint32_t, TestIdInterface*> map;
+        FlatAddressMap<uint32_t, TestIdInterface*, EASTLAllocatorType> flat;
+        for (uint32_t i = 0; i < addressCount; ++i)
+        {
+            map.emplace(ids[i], &mapHandlers[i]);
+            flat.emplace(eastl::pair<uint32_t, TestIdInterface*>(ids[i], &flatHandlers[i]));
+        }
+
+        eastl::vector<uint32_t> lookups(1 << 20);
+        std::mt19937 random(addressCount);
+        for (uint32_t& id : lookups)
+        {
+            id = ids[random() % addressCount];
+        }
+
+        // 先预热一轮，只计第二轮
+        auto measure = [&lookups](auto&& lookup)
+        {
+            double time = 0;
+            for (int round = 0; round < 2; ++round)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                for (uint32_t id : lookups)
+                {
+                    lookup(id);
+                }
+                const std::chrono::duration<double, std::nano> span = std::chrono::steady_clock::now() - start;
+                time = span.count() / lookups.size();
+            }
+            return time;
+        };
+
+        const double mapTime = measure([&map](uint32_t id)
+        {
+            map.find(id)->second->OnEvent();
+        });
+        const double flatTime = measure([&flat](uint32_t id)
+        {
+            flat.find(id)->second->OnEvent();
+        });
+        const double mapEventTime = measure([](uint32_t id)
+        {
+            TestIdBus::Event(id, &TestIdBus::Events::OnEvent);
+        });
+        const double flatEventTime = measure([](uint32_t id)
+        {
+            FlatIdBus::Event(id, &FlatIdBus::Events::OnEvent);
+        });
+
+        uint32_t calls = 0;
+        for (uint32_t i = 0; i < addressCount; ++i)
+        {
+            calls += mapHandlers[i].m_callEvents + flatHandlers[i].m_callEvents;
+            mapHandlers[i].BusDisconnect();
+            flatHandlers[i].BusDisconnect();
+        }
+        EXPECT_EQ(calls, lookups.size() * 8);
+        std::cout << "[EBusTest] " << addressCount << " addresses, lookup unordered_map: " << mapTime << " ns, FlatAddressMap: "
+            << flatTime << " ns; Event unordered_map: " << mapEventTime << " ns, FlatAddressMap: " << flatEventTime << " ns" << std::endl;
+    }
+    EXPECT_FALSE(TestIdBus::HasHandlers());
+    EXPECT_FALSE(FlatIdBus::HasHandlers());
+}
+
 class HandlerOrderTraits: public EBusTraits
 {
 public:
@@ -211,6 +399,121 @@ TEST(EBusTest, OrderedHandlerTest)
     handler2.BusDisconnect(100);
 }
 
+class OrderKeyInterface: public EBusTraits
+{
+public:
+    static const EBusHandlerPolicy HandlerPolicy = EBusHandlerPolicy::MultipleAndOrdered;
+    static const EBusAddressPolicy AddressPolicy = EBusAddressPolicy::Single;
+
+    using BusHandlerOrderKey = int;
+    static BusHandlerOrderKey GetHandlerOrderKey(const OrderKeyInterface* handler)
+    {
+        ++s_keyReads;
+        return handler->GetOrder();
+    }
+
+public:
+    virtual int GetOrder() const = 0;
+    virtual void OnOrderEvent(eastl::vector<int>& calls) = 0;
+
+    static inline uint32_t s_keyReads {0};
+};
+
+using OrderKeyBus = EBus<OrderKeyInterface>;
+
+class OrderKeyHandler: public OrderKeyBus::Handler
+{
+public:
+    int GetOrder() const override
+    {
+        return m_order;
+    }
+
+    void OnOrderEvent(eastl::vector<int>& calls) override
+    {
+        calls.push_back(m_id);
+        if (m_disconnect)
+        {
+            m_disconnect->BusDisconnect();
+        }
+    }
+
+public:
+    int m_order {0};
+    int m_id {0};
+    OrderKeyHandler* m_disconnect {nullptr};
+};
+
+TEST(EBusTest, OrderedHandlerKeyTest)
+{
+    static constexpr int handlerCount = 1000;
+    eastl::vector<OrderKeyHandler> handlers(handlerCount);
+    eastl::vector<int> expected;
+    for (int i = 0; i < handlerCount; ++i)
+    {
+        // 相同的键按连接顺序排列
+        handlers[i].m_order = (i * 7919) % 100;
+        handlers[i].m_id = i;
+    }
+    for (int order = 0; order < 100; ++order)
+    {
+        for (int i = 0; i < handlerCount; ++i)
+        {
+            if (handlers[i].m_order == order)
+            {
+                expected.push_back(i);
+            }
+        }
+    }
+
+    OrderKeyInterface::s_keyReads = 0;
+    for (auto& handler: handlers)
+    {
+        handler.BusConnect();
+    }
+    EXPECT_EQ(OrderKeyInterface::s_keyReads, handlerCount);
+    EXPECT_EQ(OrderKeyBus::GetTotalNumOfEventHandlers(), handlerCount);
+
+    eastl::vector<int> calls;
+    OrderKeyBus::Broadcast(&OrderKeyInterface::OnOrderEvent, calls);
+    EXPECT_EQ(calls, expected);
+
+    // 分发中断开自己和下一个处理器
+    OrderKeyHandler& first = handlers[expected[0]];
+    OrderKeyHandler& second = handlers[expected[1]];
+    OrderKeyHandler& third = handlers[expected[2]];
+    first.m_disconnect = &second;
+    third.m_disconnect = &third;
+    calls.clear();
+    OrderKeyBus::Broadcast(&OrderKeyInterface::OnOrderEvent, calls);
+    EXPECT_EQ(calls.size(), handlerCount - 1);
+    EXPECT_EQ(calls[0], expected[0]);
+    EXPECT_EQ(calls[1], expected[2]);
+    EXPECT_EQ(calls[2], expected[3]);
+    EXPECT_EQ(OrderKeyBus::GetTotalNumOfEventHandlers(), handlerCount - 2);
+    first.m_disconnect = nullptr;
+    third.m_disconnect = nullptr;
+
+    // 断开一半后顺序不变
+    for (int i = 0; i < handlerCount; i += 2)
+    {
+        handlers[i].BusDisconnect();
+    }
+    calls.clear();
+    OrderKeyBus::Broadcast(&OrderKeyInterface::OnOrderEvent, calls);
+    expected.erase(eastl::remove_if(expected.begin(), expected.end(), [&](int id)
+    {
+        return id % 2 == 0 || id == second.m_id || id == third.m_id;
+    }), expected.end());
+    EXPECT_EQ(calls, expected);
+
+    for (auto& handler: handlers)
+    {
+        handler.BusDisconnect();
+    }
+    EXPECT_FALSE(OrderKeyBus::HasHandlers());
+}
+
 class AddressOrderTraits: public EBusTraits
 {
 public:
@@ -393,6 +696,286 @@ TEST(EBusTest, QueueEventTest)
     h2.BusDisconnect();
 }
 
+struct CountingAllocator: public eastl::allocator
+{
+    CountingAllocator(const char* name = EASTL_NAME_VAL(EASTL_ALLOCATOR_DEFAULT_NAME)): eastl::allocator(name) {}
+    CountingAllocator(const CountingAllocator& other, const char* name): eastl::allocator(other, name) {}
+
+    void* allocate(size_t n, int flags = 0)
+    {
+        ++s_allocations;
+        return eastl::allocator::allocate(n, flags);
+    }
+
+    void* allocate(size_t n, size_t alignment, size_t offset, int flags = 0)
+    {
+        ++s_allocations;
+        return eastl::allocator::allocate(n, alignment, offset, flags);
+    }
+
+    static inline size_t s_allocations {0};
+};
+
+struct QueuePayload
+{
+    QueuePayload(uint32_t value): m_value(value) {}
+    QueuePayload(const QueuePayload& other): m_value(other.m_value) {}
+    ~QueuePayload() { ++s_destroyed; }
+
+    uint32_t m_value;
+    uint64_t m_data[4] {};
+
+    static inline size_t s_destroyed {0};
+};
+
+class CommandQueueTraits: public EBusTraits
+{
+public:
+    static const EBusHandlerPolicy HandlerPolicy = EBusHandlerPolicy::Multiple;
+    static const EBusAddressPolicy AddressPolicy = EBusAddressPolicy::Single;
+
+    static constexpr bool EnableEventQueue = true;
+    using AllocatorType = CountingAllocator;
+};
+
+class CommandQueueInterface
+{
+public:
+    virtual void OnPayload(const QueuePayload& payload, uint32_t index) = 0;
+};
+
+using CommandQueueBus = EBus<CommandQueueInterface, CommandQueueTraits>;
+
+class CommandQueueHandler: public CommandQueueBus::Handler
+{
+public:
+    void OnPayload(const QueuePayload& payload, uint32_t index) override
+    {
+        m_inOrder = m_inOrder && payload.m_value == m_received && index == m_received;
+        ++m_received;
+        if (m_requeue)
+        {
+            // 执行过程中入队的事件留到下一次Execute
+            m_requeue = false;
+            CommandQueueBus::QueueBroadcast(&CommandQueueBus::Events::OnPayload, QueuePayload(m_received), m_received);
+        }
+    }
+
+public:
+    uint32_t m_received {0};
+    bool m_inOrder {true};
+    bool m_requeue {false};
+};
+
+TEST(EBusTest, QueueCommandBufferTest)
+{
+    CommandQueueHandler handler;
+    handler.BusConnect();
+
+    static constexpr uint32_t eventCount = 10000;
+    auto QueueEvents = [](uint32_t first)
+    {
+        for (uint32_t i = first; i < first + eventCount; ++i)
+        {
+            CommandQueueBus::QueueBroadcast(&CommandQueueBus::Events::OnPayload, QueuePayload(i), i);
+        }
+    };
+
+    // 第一轮分配页面
+    QueueEvents(0);
+    EXPECT_EQ(CommandQueueBus::QueuedEventCount(), eventCount);
+    QueuePayload::s_destroyed = 0;
+    CommandQueueBus::ExecuteQueuedEvents();
+    EXPECT_EQ(handler.m_received, eventCount);
+    EXPECT_EQ(QueuePayload::s_destroyed, eventCount);
+    EXPECT_EQ(CommandQueueBus::QueuedEventCount(), 0);
+
+    // 两个缓冲区都使用过之后入队不再分配内存
+    QueueEvents(eventCount);
+    CommandQueueBus::ExecuteQueuedEvents();
+
+    const size_t allocations = CountingAllocator::s_allocations;
+    QueueEvents(eventCount * 2);
+    CommandQueueBus::ExecuteQueuedEvents();
+    EXPECT_EQ(CountingAllocator::s_allocations, allocations);
+    EXPECT_EQ(handler.m_received, eventCount * 3);
+    EXPECT_TRUE(handler.m_inOrder);
+
+    // 执行中入队、清空
+    handler.m_requeue = true;
+    QueueEvents(eventCount * 3);
+    CommandQueueBus::ExecuteQueuedEvents();
+    EXPECT_EQ(CommandQueueBus::QueuedEventCount(), 1);
+    QueuePayload::s_destroyed = 0;
+    CommandQueueBus::ClearQueuedEvents();
+    EXPECT_EQ(QueuePayload::s_destroyed, 1);
+    EXPECT_EQ(CommandQueueBus::QueuedEventCount(), 0);
+    EXPECT_EQ(handler.m_received, eventCount * 4);
+
+    handler.BusDisconnect();
+}
+
+template<EBusEventQueuePolicy Policy>
+class PerThreadQueueTraits: public EBusTraits
+{
+public:
+    static const EBusHandlerPolicy HandlerPolicy = EBusHandlerPolicy::Multiple;
+    static const EBusAddressPolicy AddressPolicy = EBusAddressPolicy::Single;
+
+    static constexpr bool EnableEventQueue = true;
+    static constexpr EBusEventQueuePolicy EventQueuePolicy = Policy;
+    using MutexType = std::mutex;
+};
+
+class PerThreadQueueInterface
+{
+public:
+    virtual void OnQueued(uint32_t producer, uint32_t index) = 0;
+};
+
+template<EBusEventQueuePolicy Policy>
+class PerThreadQueueHandler: public EBus<PerThreadQueueInterface, PerThreadQueueTraits<Policy>>::Handler
+{
+public:
+    void OnQueued(uint32_t producer, uint32_t index) override
+    {
+        m_events.push_back({producer, index});
+    }
+
+public:
+    eastl::vector<eastl::pair<uint32_t, uint32_t>> m_events;
+};
+
+TEST(EBusTest, PerThreadQueueTest)
+{
+    using Bus = EBus<PerThreadQueueInterface, PerThreadQueueTraits<EBusEventQueuePolicy::PerThread>>;
+    PerThreadQueueHandler<EBusEventQueuePolicy::PerThread> handler;
+    handler.BusConnect();
+
+    // 生产者与消费者并发，每个生产者的事件保持顺序
+    static constexpr uint32_t threadCount = 4;
+    static constexpr uint32_t eventCount = 5000;
+    eastl::fixed_vector<std::thread, threadCount> threads;
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back([i]()
+        {
+            for (uint32_t j = 0; j < eventCount; ++j)
+            {
+                Bus::QueueBroadcast(&PerThreadQueueInterface::OnQueued, i, j);
+            }
+        });
+    }
+    while (handler.m_events.size() < threadCount * eventCount)
+    {
+        Bus::ExecuteQueuedEvents();
+    }
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+    Bus::ExecuteQueuedEvents();
+    EXPECT_EQ(handler.m_events.size(), threadCount * eventCount);
+    EXPECT_EQ(Bus::QueuedEventCount(), 0);
+
+    uint32_t expected[threadCount] {};
+    bool inOrder = true;
+    for (auto [producer, index]: handler.m_events)
+    {
+        inOrder = inOrder && index == expected[producer]++;
+    }
+    EXPECT_TRUE(inOrder);
+
+    Bus::QueueBroadcast(&PerThreadQueueInterface::OnQueued, 0u, 0u);
+    EXPECT_EQ(Bus::QueuedEventCount(), 1);
+    Bus::ClearQueuedEvents();
+    EXPECT_EQ(Bus::QueuedEventCount(), 0);
+
+    handler.BusDisconnect();
+}
+
+class PerThreadEnvironmentTraits: public PerThreadQueueTraits<EBusEventQueuePolicy::PerThread>
+{
+public:
+    template <typename Context>
+    using StoragePolicy = EBusEnvironmentStoragePolicy<Context>;
+};
+
+using EnvironmentQueueBus = EBus<PerThreadQueueInterface, PerThreadEnvironmentTraits>;
+
+class PerThreadEnvironmentHandler: public EnvironmentQueueBus::Handler
+{
+public:
+    void OnQueued(uint32_t producer, uint32_t index) override
+    {
+        m_events.push_back({producer, index});
+    }
+
+    eastl::vector<eastl::pair<uint32_t, uint32_t>> m_events;
+};
+
+TEST(EBusTest, PerThreadQueueContexts)
+{
+    // 交替向多个环境的context入队，超过线程缓存的数量时仍找回原来的队列
+    static constexpr uint32_t contextCount = 6;
+    EBusEnvironment environments[contextCount];
+    PerThreadEnvironmentHandler handlers[contextCount];
+    for (uint32_t i = 0; i < contextCount; ++i)
+    {
+        EBusEnvironment::Scope scope(&environments[i]);
+        handlers[i].BusConnect();
+    }
+    for (uint32_t round = 0; round < 100; ++round)
+    {
+        for (uint32_t i = 0; i < contextCount; ++i)
+        {
+            EBusEnvironment::Scope scope(&environments[i]);
+            EnvironmentQueueBus::QueueBroadcast(&PerThreadQueueInterface::OnQueued, i, round);
+        }
+    }
+    for (uint32_t i = 0; i < contextCount; ++i)
+    {
+        EBusEnvironment::Scope scope(&environments[i]);
+        EXPECT_EQ(EnvironmentQueueBus::QueuedEventCount(), 100);
+        EnvironmentQueueBus::ExecuteQueuedEvents();
+        ASSERT_EQ(handlers[i].m_events.size(), 100);
+        EXPECT_EQ(handlers[i].m_events.back().first, i);
+        EXPECT_EQ(handlers[i].m_events.back().second, 99);
+        handlers[i].BusDisconnect();
+    }
+}
+
+TEST(EBusTest, PerThreadOrderedQueueTest)
+{
+    using Bus = EBus<PerThreadQueueInterface, PerThreadQueueTraits<EBusEventQueuePolicy::PerThreadOrdered>>;
+    PerThreadQueueHandler<EBusEventQueuePolicy::PerThreadOrdered> handler;
+    handler.BusConnect();
+
+    // 不同线程交替入队，按入队顺序执行
+    uint32_t index = 0;
+    for (uint32_t round = 0; round < 3; ++round)
+    {
+        Bus::QueueBroadcast(&PerThreadQueueInterface::OnQueued, 0u, index++);
+        std::thread([&index]()
+        {
+            Bus::QueueBroadcast(&PerThreadQueueInterface::OnQueued, 1u, index++);
+            Bus::QueueBroadcast(&PerThreadQueueInterface::OnQueued, 1u, index++);
+        }).join();
+        std::thread([&index]()
+        {
+            Bus::QueueBroadcast(&PerThreadQueueInterface::OnQueued, 2u, index++);
+        }).join();
+    }
+    Bus::ExecuteQueuedEvents();
+    ASSERT_EQ(handler.m_events.size(), index);
+    for (uint32_t i = 0; i < index; ++i)
+    {
+        EXPECT_EQ(handler.m_events[i].second, i);
+    }
+
+    handler.BusDisconnect();
+}
+
 struct MultiThreadTraits: public EBusTraits
 {
     static const EBusHandlerPolicy HandlerPolicy = EBusHandlerPolicy::Multiple;
@@ -526,4 +1109,241 @@ TEST(EBusTest, EBusResultRTest)
         sum2 += value;
     }
     EXPECT_EQ(sum2, actulSum);
-}
\ No newline at end of file
+}
+class EnvironmentInterface: public EBusTraits
+{
+public:
+    static const EBusHandlerPolicy HandlerPolicy = EBusHandlerPolicy::Multiple;
+    static const EBusAddressPolicy AddressPolicy = EBusAddressPolicy::Single;
+
+    using MutexType = std::recursive_mutex;
+
+    template <typename Context>
+    using StoragePolicy = EBusEnvironmentStoragePolicy<Context>;
+
+public:
+    virtual void OnEvent() = 0;
+};
+
+using EnvironmentBus = EBus<EnvironmentInterface>;
+
+class EnvironmentBusHandler: public EnvironmentBus::Handler
+{
+public:
+    void OnEvent() override
+    {
+        m_callEvents++;
+        if (m_nested)
+        {
+            m_nested();
+        }
+    }
+
+public:
+    uint32_t m_callEvents {0};
+    eastl::function<void()> m_nested;
+};
+
+TEST(EBusTest, EnvironmentTest)
+{
+    EnvironmentBusHandler globalHandler;
+    globalHandler.BusConnect();
+
+    EBusEnvironment environment1;
+    EBusEnvironment environment2;
+    EnvironmentBusHandler handler1;
+    EnvironmentBusHandler handler2;
+    {
+        EBusEnvironment::Scope scope(&environment1);
+        EXPECT_EQ(EBusEnvironment::GetCurrent(), &environment1);
+        EXPECT_FALSE(EnvironmentBus::HasHandlers());
+        handler1.BusConnect();
+    }
+    {
+        EBusEnvironment::Scope scope(&environment2);
+        handler2.BusConnect();
+        EnvironmentBus::Broadcast(&EnvironmentBus::Events::OnEvent);
+
+        // 空环境沿用当前环境
+        EBusEnvironment::Scope nullScope(nullptr);
+        EXPECT_EQ(EBusEnvironment::GetCurrent(), &environment2);
+    }
+    EXPECT_EQ(EBusEnvironment::GetCurrent(), nullptr);
+    EXPECT_EQ(handler1.m_callEvents, 0);
+    EXPECT_EQ(handler2.m_callEvents, 1);
+    EXPECT_EQ(globalHandler.m_callEvents, 0);
+
+    // 没有激活的环境时使用全局context
+    EnvironmentBus::Broadcast(&EnvironmentBus::Events::OnEvent);
+    EXPECT_EQ(globalHandler.m_callEvents, 1);
+    EXPECT_EQ(EnvironmentBus::GetTotalNumOfEventHandlers(), 1);
+
+    // 两个环境在不同线程上同时派发
+    std::thread thread1([&]()
+    {
+        EBusEnvironment::Scope scope(&environment1);
+        for (int i = 0; i < 1000; ++i)
+        {
+            EnvironmentBus::Broadcast(&EnvironmentBus::Events::OnEvent);
+        }
+    });
+    std::thread thread2([&]()
+    {
+        EBusEnvironment::Scope scope(&environment2);
+        for (int i = 0; i < 1000; ++i)
+        {
+            EnvironmentBus::Broadcast(&EnvironmentBus::Events::OnEvent);
+        }
+    });
+    thread1.join();
+    thread2.join();
+    EXPECT_EQ(handler1.m_callEvents, 1000);
+    EXPECT_EQ(handler2.m_callEvents, 1001);
+    EXPECT_EQ(globalHandler.m_callEvents, 1);
+
+    {
+        EBusEnvironment::Scope scope(&environment1);
+        handler1.BusDisconnect();
+    }
+    {
+        EBusEnvironment::Scope scope(&environment2);
+        handler2.BusDisconnect();
+    }
+    globalHandler.BusDisconnect();
+
+    // 默认的存储策略不区分环境
+    TestBusHandler testHandler;
+    {
+        EBusEnvironment::Scope scope(&environment1);
+        testHandler.BusConnect();
+    }
+    TestBus::Broadcast(&TestBus::Events::OnEvent);
+    EXPECT_EQ(testHandler.m_callEvents, 1);
+    testHandler.BusDisconnect();
+}
+
+TEST(EBusTest, EnvironmentNestedDispatch)
+{
+    EBusEnvironment environment1;
+    EBusEnvironment environment2;
+    EnvironmentBusHandler handler1;
+    EnvironmentBusHandler handler2;
+    {
+        EBusEnvironment::Scope scope(&environment2);
+        handler2.BusConnect();
+    }
+    {
+        EBusEnvironment::Scope scope(&environment1);
+        handler1.BusConnect();
+
+        // 派发中切换到另一个环境派发同一总线，各环境的调用栈互不影响
+        handler1.m_nested = [&]()
+        {
+            EBusEnvironment::Scope nestedScope(&environment2);
+            EXPECT_FALSE(EnvironmentBus::IsInDispatchThisThread());
+            EnvironmentBus::Broadcast(&EnvironmentBus::Events::OnEvent);
+            handler2.BusDisconnect();
+        };
+        EnvironmentBus::Broadcast(&EnvironmentBus::Events::OnEvent);
+        EXPECT_TRUE(handler1.BusIsConnected());
+        EXPECT_FALSE(EnvironmentBus::IsInDispatchThisThread());
+        handler1.BusDisconnect();
+    }
+    EXPECT_EQ(handler1.m_callEvents, 1);
+    EXPECT_EQ(handler2.m_callEvents, 1);
+}
+
+class SnapshotInterface: public EBusTraits
+{
+public:
+    static const EBusHandlerPolicy HandlerPolicy = EBusHandlerPolicy::Multiple;
+    static const EBusAddressPolicy AddressPolicy = EBusAddressPolicy::Single;
+    static constexpr bool SnapshotDispatch = true;
+
+    using MutexType = std::recursive_mutex;
+
+public:
+    virtual void OnSnapshotEvent() = 0;
+};
+
+using SnapshotBus = EBus<SnapshotInterface>;
+
+class SnapshotHandler: public SnapshotBus::Handler
+{
+public:
+    void OnSnapshotEvent() override
+    {
+        m_callEvents++;
+        if (m_disconnect)
+        {
+            m_disconnect->BusDisconnect();
+        }
+    }
+
+public:
+    std::atomic<uint32_t> m_callEvents {0};
+    SnapshotHandler* m_disconnect {nullptr};
+};
+
+TEST(EBusTest, SnapshotDispatchTest)
+{
+    SnapshotHandler h1, h2, h3;
+    h1.BusConnect();
+    h2.BusConnect();
+    h3.BusConnect();
+    EXPECT_EQ(SnapshotBus::GetTotalNumOfEventHandlers(), 3);
+
+    SnapshotBus::Broadcast(&SnapshotBus::Events::OnSnapshotEvent);
+    EXPECT_EQ(h1.m_callEvents, 1);
+    EXPECT_EQ(h2.m_callEvents, 1);
+    EXPECT_EQ(h3.m_callEvents, 1);
+
+    // 分发中断开的处理器不会再被调用，无论它在快照中的位置
+    h1.m_disconnect = &h2;
+    h2.m_disconnect = &h1;
+    SnapshotBus::Broadcast(&SnapshotBus::Events::OnSnapshotEvent);
+    EXPECT_EQ(h1.m_callEvents + h2.m_callEvents, 3);
+    EXPECT_EQ(h3.m_callEvents, 2);
+    EXPECT_EQ(SnapshotBus::GetTotalNumOfEventHandlers(), 2);
+    h1.m_disconnect = nullptr;
+    h2.m_disconnect = nullptr;
+    h1.BusDisconnect();
+    h2.BusDisconnect();
+
+    // 派发线程与连接线程并发，派发不加锁
+    static constexpr int threadCount = 4;
+    static constexpr int loop = 2000;
+    std::atomic<bool> stop {false};
+    eastl::fixed_vector<std::thread, threadCount> threads;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back([]()
+        {
+            for (int j = 0; j < loop; ++j)
+            {
+                SnapshotBus::Broadcast(&SnapshotBus::Events::OnSnapshotEvent);
+            }
+        });
+    }
+    std::thread connector([&stop]()
+    {
+        while (!stop)
+        {
+            // Disconnect等待其他线程的派发结束，析构后不会再被调用
+            auto handler = eastl::make_unique<SnapshotHandler>();
+            handler->BusConnect();
+            handler->BusDisconnect();
+        }
+    });
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+    stop = true;
+    connector.join();
+
+    EXPECT_EQ(h3.m_callEvents, 2 + threadCount * loop);
+    EXPECT_EQ(SnapshotBus::GetTotalNumOfEventHandlers(), 1);
+    h3.BusDisconnect();
+    EXPECT_FALSE(SnapshotBus::HasHandlers());
+}
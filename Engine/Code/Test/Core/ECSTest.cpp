@@ -1,16 +1,23 @@
 #include <EASTL/string.h>
 #include <EASTL/vector.h>
+#include <EASTL/array.h>
+#include <EASTL/sort.h>
 #include <gtest/gtest.h>
 
 #include <ECS/Entity.h>
 #include <ECS/WorldContext.h>
 #include <ECS/Tag.h>
 #include <ECS/ISystem.h>
+#include <ECS/EntityMap.h>
+#include <ECS/ComponentObserver.h>
+#include <ECS/Prefab.h>
+#include <Jobs/JobSystem.h>
 #include <Service/Service.h>
 #include <Log/SpdLogSystem.h>
 #include <CoreComponents/Name.h>
 
 #include <iostream>
+#include <atomic>
 
 using namespace Spark;
 
@@ -490,6 +497,45 @@ TEST(ECSTest, EntityBus)
     EXPECT_EQ(handler.Count(), 0);
 }
 
+class BulkEntityHandler : public EntityHandler
+{
+public:
+    void OnEntitiesCreate(eastl::span<const Entity> entities) override
+    {
+        m_bulkCount++;
+        EntityHandler::OnEntitiesCreate(entities);
+    }
+
+    uint32_t BulkCount() const
+    {
+        return m_bulkCount;
+    }
+
+private:
+    uint32_t m_bulkCount {0};
+};
+
+TEST(ECSTest, BulkEntityBus)
+{
+    WorldContext context;
+    {
+        // 只实现单个实体事件的Handler通过默认实现接收批量事件
+        EntityHandler handler;
+        eastl::vector<Entity> entities(100);
+        context.CreateEntity(entities.begin(), entities.end());
+        EXPECT_EQ(handler.Count(), 100);
+        EXPECT_EQ(handler.Last(), entities.back());
+        context.DestoryEntity(entities.begin(), entities.end());
+        EXPECT_EQ(handler.Count(), 0);
+    }
+
+    BulkEntityHandler handler;
+    eastl::array<Entity, 10> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    EXPECT_EQ(handler.BulkCount(), 1);
+    EXPECT_EQ(handler.Count(), 10);
+}
+
 class ComponentHandler : ComponentEventBus::MultiHandler
 {
 public:
@@ -600,3 +646,574 @@ TEST(ECSTest, DestoryEntityAndComponentBus)
     EXPECT_FLOAT_EQ(handler.m_position.x, 0.f);
     EXPECT_FLOAT_EQ(handler.m_position.y, 0.f);
 }
+
+TEST(ECSTest, EntityMap)
+{
+    WorldContext context;
+    EntityMap<int> map;
+
+    Entity ent1 = context.CreateEntity();
+    Entity ent2 = context.CreateEntity();
+    Entity ent3 = context.CreateEntity();
+
+    EXPECT_TRUE(map.TryEmplace(ent1, 1).second);
+    EXPECT_TRUE(map.TryEmplace(ent2, 2).second);
+    EXPECT_FALSE(map.TryEmplace(ent2, 5).second);
+    map[ent3] = 3;
+    EXPECT_EQ(map.Size(), 3);
+    EXPECT_EQ(*map.Find(ent2), 2);
+
+    // 删除后最后一个元素移动到空位
+    EXPECT_TRUE(map.Erase(ent1));
+    EXPECT_FALSE(map.Erase(ent1));
+    EXPECT_EQ(map.Size(), 2);
+    EXPECT_EQ(map.Find(ent1), nullptr);
+    EXPECT_EQ(map.Entities()[0], ent3);
+    EXPECT_EQ(map.Values()[0], 3);
+
+    // 实体回收后旧版本不再命中
+    context.DestoryEntity(ent3);
+    Entity recycled = context.CreateEntity();
+    ASSERT_EQ(entt::to_entity(recycled), entt::to_entity(ent3));
+    EXPECT_FALSE(map.Contains(recycled));
+    map.InsertOrAssign(recycled, 4);
+    EXPECT_EQ(map.Size(), 2);
+    EXPECT_FALSE(map.Contains(ent3));
+    EXPECT_EQ(*map.Find(recycled), 4);
+
+    EntitySet set;
+    EXPECT_TRUE(set.Insert(ent2).second);
+    EXPECT_FALSE(set.Insert(ent2).second);
+    EXPECT_TRUE(set.Contains(ent2));
+    set.Clear();
+    EXPECT_TRUE(set.Empty());
+}
+
+TEST(ECSTest, ComponentObserver)
+{
+    WorldContext context;
+    auto ent1 = context.CreateEntity();
+    auto ent2 = context.CreateEntity();
+    context.Add<Position>(ent1, 1.f, 1.f);
+
+    // 没有监听者时Repalce直接赋值
+    EXPECT_FALSE(context.HasListeners<Position>());
+    context.Repalce<Position>(ent1, 2.f, 2.f);
+    EXPECT_FLOAT_EQ(context.Get<Position>(ent1).x, 2.f);
+
+    ComponentObserver<Position> observer;
+    observer.Connect(context);
+    EXPECT_TRUE(context.HasListeners<Position>());
+
+    context.Add<Position>(ent2, 1.f, 1.f);
+    context.Repalce<Position>(ent2, 3.f, 3.f);
+    context.AddOrRepalce<Position>(ent1, 4.f, 4.f);
+    ASSERT_EQ(observer.GetConstructed().size(), 1);
+    EXPECT_EQ(observer.GetConstructed()[0], ent2);
+    ASSERT_EQ(observer.GetUpdated().size(), 1);
+    EXPECT_EQ(observer.GetUpdated()[0], ent1);
+
+    context.DestoryEntity(ent1);
+    EXPECT_TRUE(observer.GetUpdated().empty());
+    ASSERT_EQ(observer.GetDestoryed().size(), 1);
+    EXPECT_EQ(observer.GetDestoryed()[0], ent1);
+
+    observer.Clear();
+    EXPECT_TRUE(observer.Empty());
+    observer.Disconnect();
+    EXPECT_FALSE(context.HasListeners<Position>());
+}
+
+TEST(ECSTest, ParallelEach)
+{
+    JobSystemConfig config;
+    config.m_workerCount = 4;
+    JobSystem jobSystem(config);
+    jobSystem.Initialize();
+
+    WorldContext context;
+    const size_t count = 100000;
+    eastl::vector<Entity> entities(count);
+    context.CreateEntity(entities.begin(), entities.end());
+    for (size_t i = 0; i < count; ++i)
+    {
+        context.Add<Position>(entities[i], static_cast<float>(i), 0.f);
+        // 只有一半实体有Velocity，遍历时需跳过其余实体
+        if (i % 2 == 0)
+        {
+            context.Add<Velocity>(entities[i], 1.f, 2.f);
+        }
+    }
+
+    std::atomic<size_t> visited {0};
+    context.ParallelEach<Position, const Velocity>([&visited](Entity entity, Position& pos, const Velocity& vel)
+    {
+        pos.x += vel.dx;
+        pos.y += vel.dy;
+        visited.fetch_add(1, std::memory_order_relaxed);
+    }, 100);
+    EXPECT_EQ(visited.load(), count / 2);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Position& pos = context.Get<Position>(entities[i]);
+        ASSERT_FLOAT_EQ(pos.x, static_cast<float>(i) + (i % 2 == 0 ? 1.f : 0.f)) << i;
+        ASSERT_FLOAT_EQ(pos.y, i % 2 == 0 ? 2.f : 0.f) << i;
+    }
+
+    // 部分聚合结果合并
+    const double sum = context.ParallelReduce<const Position>(0.0,
+        [](double& partial, Entity, const Position& pos) { partial += pos.y; },
+        [](double& result, const double& partial) { result += partial; });
+    EXPECT_DOUBLE_EQ(sum, 2.0 * (count / 2));
+
+    auto group = context.CreateGroup<Position>(Include<Velocity>);
+    visited.store(0);
+    context.ParallelEachIn(group, [&visited](Entity, Position& pos, Velocity&)
+    {
+        pos.y = -1.f;
+        visited.fetch_add(1, std::memory_order_relaxed);
+    });
+    EXPECT_EQ(visited.load(), count / 2);
+    EXPECT_FLOAT_EQ(context.Get<Position>(entities[0]).y, -1.f);
+    EXPECT_FLOAT_EQ(context.Get<Position>(entities[1]).y, 0.f);
+
+    jobSystem.ShutDown();
+
+    // 没有worker时在调用线程遍历
+    visited.store(0);
+    context.ParallelEach<const Velocity>([&visited](Entity, const Velocity&) { visited.fetch_add(1); });
+    EXPECT_EQ(visited.load(), count / 2);
+}
+
+TEST(ECSTest, CommandBuffer)
+{
+    JobSystemConfig config;
+    config.m_workerCount = 4;
+    JobSystem jobSystem(config);
+    jobSystem.Initialize();
+
+    WorldContext context;
+    BulkEntityHandler handler;
+
+    eastl::vector<Entity> existing(1000);
+    context.CreateEntity(existing.begin(), existing.end());
+    for (Entity entity : existing)
+    {
+        context.Add<Position>(entity, 0.f, 0.f);
+    }
+    EXPECT_EQ(handler.Count(), 1000);
+
+    const size_t spawnCount = 1000;
+    context.ReserveEntities(spawnCount);
+    // 预留实体在回放前不发送创建事件
+    EXPECT_EQ(handler.Count(), 1000);
+
+    // worker线程中生成和销毁实体
+    jobSystem.ParallelFor(0, spawnCount, [&context, &existing](size_t first, size_t last)
+    {
+        CommandBuffer& buffer = context.GetCommandBuffer();
+        for (size_t i = first; i < last; ++i)
+        {
+            Entity entity = buffer.CreateEntity();
+            buffer.Add<Position>(entity, static_cast<float>(i), 1.f);
+            buffer.Add<Name>(entity, eastl::string("Spawned"));
+            if (i % 2 == 0)
+            {
+                buffer.DestoryEntity(existing[i]);
+                // 重复销毁只执行一次
+                buffer.DestoryEntity(existing[i]);
+            }
+            else
+            {
+                buffer.Remove<Position>(existing[i]);
+            }
+        }
+    }, 16);
+
+    EXPECT_EQ(context.GetView<Position>().size(), 1000);
+    const uint32_t bulkCount = handler.BulkCount();
+    context.PlaybackCommands();
+    EXPECT_EQ(handler.BulkCount(), bulkCount + 1);
+    EXPECT_EQ(handler.Count(), 1000 + spawnCount - 500);
+
+    size_t spawned = 0;
+    float sum = 0.f;
+    context.GetView<const Position, const Name>().each([&](Entity, const Position& pos, const Name& name)
+    {
+        EXPECT_EQ(name.name, "Spawned");
+        EXPECT_FLOAT_EQ(pos.y, 1.f);
+        sum += pos.x;
+        ++spawned;
+    });
+    EXPECT_EQ(spawned, spawnCount);
+    EXPECT_FLOAT_EQ(sum, static_cast<float>(spawnCount * (spawnCount - 1) / 2));
+    for (size_t i = 0; i < existing.size(); ++i)
+    {
+        EXPECT_EQ(context.Valid(existing[i]), i % 2 != 0) << i;
+        if (i % 2 != 0)
+        {
+            EXPECT_FALSE(context.Has<Position>(existing[i]));
+        }
+    }
+
+    // 预留量按上一帧的使用量补充，缓冲已清空
+    EXPECT_TRUE(context.GetCommandBuffer().Empty());
+    Entity entity = context.GetCommandBuffer().CreateEntity();
+    EXPECT_NE(entity, NullEntity);
+    // 回放前预留实体无效
+    EXPECT_FALSE(context.Valid(entity));
+    context.GetCommandBuffer().Add<Position>(entity, 5.f, 5.f);
+    context.GetCommandBuffer().Remove<Position>(entity);
+    context.PlaybackCommands();
+    EXPECT_TRUE(context.Valid(entity));
+    EXPECT_FALSE(context.Has<Position>(entity));
+
+    // 丢弃的命令中取出的预留实体回到预留池
+    Entity dropped = context.GetCommandBuffer().CreateEntity();
+    context.GetCommandBuffer().Add<Position>(dropped, 6.f, 6.f);
+    context.GetCommandBuffer().Reset();
+    const size_t created = handler.Count();
+    context.PlaybackCommands();
+    EXPECT_EQ(handler.Count(), created);
+    EXPECT_FALSE(context.Valid(dropped));
+    EXPECT_EQ(context.GetCommandBuffer().CreateEntity(), dropped);
+    context.PlaybackCommands();
+    EXPECT_TRUE(context.Valid(dropped));
+    EXPECT_EQ(handler.Count(), created + 1);
+
+    // 同一组件的移除和添加按记录顺序执行
+    context.GetCommandBuffer().Remove<Position>(dropped);
+    context.GetCommandBuffer().Add<Position>(dropped, 7.f, 7.f);
+    context.GetCommandBuffer().Add<Velocity>(entity, 1.f, 1.f);
+    context.GetCommandBuffer().Remove<Velocity>(entity);
+    context.PlaybackCommands();
+    ASSERT_TRUE(context.Has<Position>(dropped));
+    EXPECT_FLOAT_EQ(context.Get<Position>(dropped).x, 7.f);
+    EXPECT_FALSE(context.Has<Velocity>(entity));
+
+    // 销毁创建命令被丢弃的预留实体不发送事件，实体回到预留池
+    Entity reserved = context.GetCommandBuffer().CreateEntity();
+    context.GetCommandBuffer().Reset();
+    context.GetCommandBuffer().DestoryEntity(reserved);
+    const size_t alive = handler.Count();
+    context.PlaybackCommands();
+    EXPECT_EQ(handler.Count(), alive);
+    EXPECT_EQ(context.GetCommandBuffer().CreateEntity(), reserved);
+    context.PlaybackCommands();
+    EXPECT_TRUE(context.Valid(reserved));
+
+    jobSystem.ShutDown();
+}
+
+TEST(ECSTest, ChangeTracking)
+{
+    WorldContext context;
+    Entity ent1 = context.CreateEntity();
+    Entity ent2 = context.CreateEntity();
+    Entity ent3 = context.CreateEntity();
+    context.Add<Position>(ent1, 1.f, 1.f);
+    context.Add<Position>(ent2, 2.f, 2.f);
+    context.Add<Velocity>(ent2, 1.f, 1.f);
+
+    // 开启记录前已存在的组件视为本帧添加
+    context.TrackChanges<Position>();
+    EXPECT_TRUE(context.IsTracked<Position>());
+    EXPECT_FALSE(context.IsTracked<Velocity>());
+    EXPECT_EQ(context.GetAddedFrame<Position>(ent1), 1);
+
+    auto Collect = [&context](auto filter)
+    {
+        eastl::vector<Entity> result;
+        context.Each<Position>(filter, [&result](Entity entity, Position&) { result.push_back(entity); });
+        eastl::sort(result.begin(), result.end());
+        return result;
+    };
+    EXPECT_EQ(Collect(Added<Position>), (eastl::vector<Entity>{ent1, ent2}));
+
+    context.AdvanceFrame();
+    EXPECT_EQ(context.GetFrame(), 2);
+    EXPECT_TRUE(Collect(Added<Position>).empty());
+    EXPECT_TRUE(Collect(Changed<Position>).empty());
+
+    // 通过引用写入需要GetMut
+    context.Get<Position>(ent1).x = 5.f;
+    EXPECT_TRUE(Collect(Changed<Position>).empty());
+    context.GetMut<Position>(ent1).x = 6.f;
+    context.Add<Position>(ent3, 3.f, 3.f);
+    EXPECT_EQ(Collect(Changed<Position>), (eastl::vector<Entity>{ent1, ent3}));
+    EXPECT_EQ(Collect(Added<Position>), (eastl::vector<Entity>{ent3}));
+    EXPECT_EQ(context.GetChangedFrame<Position>(ent1), 2);
+    EXPECT_EQ(context.GetAddedFrame<Position>(ent1), 1);
+
+    // 附加组件只返回同时拥有的实体
+    eastl::vector<Entity> moving;
+    context.Each<Position, const Velocity>(Changed<Position>, [&moving](Entity entity, Position&, const Velocity&)
+    {
+        moving.push_back(entity);
+    });
+    EXPECT_TRUE(moving.empty());
+
+    context.AdvanceFrame();
+    context.Repalce<Position>(ent2, 4.f, 4.f);
+    context.Patch<Position>(ent3, [](Position& pos) { pos.x = 7.f; });
+    context.Each<Position, const Velocity>(Changed<Position>, [&moving](Entity entity, Position& pos, const Velocity&)
+    {
+        EXPECT_FLOAT_EQ(pos.x, 4.f);
+        moving.push_back(entity);
+    });
+    EXPECT_EQ(moving, (eastl::vector<Entity>{ent2}));
+    EXPECT_EQ(Collect(Changed<Position>), (eastl::vector<Entity>{ent2, ent3}));
+
+    // 按帧号查询多帧内的修改
+    context.AdvanceFrame();
+    EXPECT_EQ(Collect(ChangedSince<Position>(2)), (eastl::vector<Entity>{ent1, ent2, ent3}));
+    EXPECT_EQ(Collect(ChangedSince<Position>(3)), (eastl::vector<Entity>{ent2, ent3}));
+
+    context.Remove<Position>(ent3);
+    EXPECT_EQ(context.GetChangedFrame<Position>(ent3), 0);
+    EXPECT_EQ(Collect(ChangedSince<Position>(3)), (eastl::vector<Entity>{ent2}));
+
+    // 过期的实体不会标记新的实体
+    context.DestoryEntity(ent2);
+    Entity ent4 = context.CreateEntity();
+    context.Add<Position>(ent4, 0.f, 0.f);
+    context.AdvanceFrame();
+    context.MarkChanged<Position>(ent2);
+    EXPECT_TRUE(Collect(Changed<Position>).empty());
+
+    // 游标返回上次读取之后的修改，与读写的先后无关
+    ChangeCursor<Position> cursor;
+    EXPECT_EQ(Collect(ChangedSince(cursor)), (eastl::vector<Entity>{ent1, ent4}));
+    EXPECT_TRUE(Collect(ChangedSince(cursor)).empty());
+    context.GetMut<Position>(ent1).x = 8.f;
+    context.AdvanceFrame();
+    EXPECT_TRUE(Collect(Changed<Position>).empty());
+    EXPECT_EQ(Collect(ChangedSince(cursor)), (eastl::vector<Entity>{ent1}));
+    EXPECT_TRUE(Collect(ChangedSince(cursor)).empty());
+
+    ChangeCursor<Position> addedCursor;
+    EXPECT_EQ(Collect(AddedSince(addedCursor)), (eastl::vector<Entity>{ent1, ent4}));
+    context.Add<Position>(ent3, 0.f, 0.f);
+    context.GetMut<Position>(ent4).x = 1.f;
+    EXPECT_EQ(Collect(AddedSince(addedCursor)), (eastl::vector<Entity>{ent3}));
+    EXPECT_EQ(Collect(ChangedSince(cursor)), (eastl::vector<Entity>{ent3, ent4}));
+}
+
+TEST(ECSTest, ChangeTrackingParallel)
+{
+    JobSystemConfig config;
+    config.m_workerCount = 4;
+    JobSystem jobSystem(config);
+    jobSystem.Initialize();
+
+    WorldContext context;
+    context.TrackChanges<Position>();
+    eastl::vector<Entity> entities(10000);
+    context.CreateEntity(entities.begin(), entities.end());
+    for (Entity entity : entities)
+    {
+        context.Add<Position>(entity, 0.f, 0.f);
+    }
+    context.AdvanceFrame();
+
+    // worker线程中标记修改
+    context.ParallelEach<Position>([&context](Entity entity, Position& pos)
+    {
+        if (entt::to_entity(entity) % 3 == 0)
+        {
+            pos.x = 1.f;
+            context.MarkChanged<Position>(entity);
+        }
+    }, 64);
+
+    size_t changed = 0;
+    context.Each<const Position>(Changed<Position>, [&changed](Entity entity, const Position& pos)
+    {
+        EXPECT_EQ(entt::to_entity(entity) % 3, 0);
+        EXPECT_FLOAT_EQ(pos.x, 1.f);
+        ++changed;
+    });
+    EXPECT_EQ(changed, (entities.size() + 2) / 3);
+
+    jobSystem.ShutDown();
+}
+
+TEST(ECSTest, BusEnvironment)
+{
+    EBusEnvironment environments[2];
+    WorldContext contexts[2];
+    EntityHandler globalHandler;
+
+    auto run = [&](size_t world)
+    {
+        WorldContext& context = contexts[world];
+        context.SetBusEnvironment(&environments[world]);
+
+        // 处理器在环境激活时连接和断开
+        EBusEnvironment::Scope scope(&environments[world]);
+        EntityHandler entityHandler;
+        ComponentHandler componentHandler;
+        context.SetupComponentEvents<Position>();
+
+        const float value = static_cast<float>(world + 1);
+        for (int i = 0; i < 1000; ++i)
+        {
+            const Entity entity = context.CreateEntity();
+            context.Add<Position>(entity, value, value);
+            EXPECT_FLOAT_EQ(componentHandler.m_position.x, value);
+        }
+        EXPECT_EQ(entityHandler.Count(), 1000);
+
+        eastl::vector<Entity> entities(500);
+        context.CreateEntity(entities.begin(), entities.end());
+        context.DestoryEntity(entities.begin(), entities.end());
+        EXPECT_EQ(entityHandler.Count(), 1000);
+    };
+
+    std::thread thread0(run, 0);
+    std::thread thread1(run, 1);
+    thread0.join();
+    thread1.join();
+
+    EXPECT_EQ(globalHandler.Count(), 0);
+    EXPECT_EQ(contexts[0].GetBusEnvironment(), &environments[0]);
+    contexts[0].Clear();
+    contexts[1].Clear();
+}
+
+struct PrefabHealth
+{
+    int32_t value;
+};
+
+struct PrefabScale
+{
+    float x;
+    float y;
+    float z;
+};
+
+struct PrefabMarker {};
+
+TEST(ECSTest, Prefab)
+{
+    Prefab prefab;
+    prefab.Set<Position>(1.f, 2.f);
+    prefab.Set<Velocity>(0.5f, 0.5f);
+    prefab.Set<Name>(eastl::string("soldier"));
+    prefab.Set<PrefabHealth>(100);
+    prefab.Set<PrefabScale>(1.f, 1.f, 1.f);
+    prefab.Set<PrefabMarker>();
+    prefab.Set<PrefabHealth>(150);
+    EXPECT_EQ(prefab.GetComponentCount(), 6);
+    EXPECT_EQ(prefab.Get<PrefabHealth>()->value, 150);
+    EXPECT_EQ(prefab.Get<PrefabMarker>(), nullptr);
+    EXPECT_TRUE(prefab.Has<PrefabMarker>());
+
+    // 拷贝后两个prefab互不影响
+    Prefab copy = prefab;
+    copy.Set<Name>(eastl::string("archer"));
+    copy.Remove<Velocity>();
+    EXPECT_EQ(prefab.Get<Name>()->name, "soldier");
+    EXPECT_EQ(copy.GetComponentCount(), 5);
+
+    WorldContext context;
+    BulkEntityHandler handler;
+    const size_t count = 10000;
+    eastl::vector<Entity> entities(count);
+    context.Instantiate(prefab, count, entities);
+
+    EXPECT_EQ(handler.BulkCount(), 1);
+    EXPECT_EQ(handler.Count(), count);
+    for (size_t i = 0; i < count; i += 997)
+    {
+        const Entity entity = entities[i];
+        ASSERT_TRUE(context.Valid(entity));
+        EXPECT_FLOAT_EQ(context.Get<Position>(entity).y, 2.f);
+        EXPECT_EQ(context.Get<PrefabHealth>(entity).value, 150);
+        EXPECT_EQ(context.Get<Name>(entity).name, "soldier");
+        EXPECT_TRUE(context.Has<PrefabMarker>(entity));
+    }
+
+    eastl::vector<Entity> copies(10);
+    context.Instantiate(copy, copies.size(), copies);
+    EXPECT_EQ(context.Get<Name>(copies[0]).name, "archer");
+    EXPECT_FALSE(context.Has<Velocity>(copies[0]));
+    EXPECT_EQ(handler.BulkCount(), 2);
+}
+
+TEST(ECSTest, TagMask)
+{
+    WorldContext context;
+    eastl::vector<Entity> entities(200);
+    context.CreateEntity(entities.begin(), entities.end());
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        context.Add<Position>(entities[i], static_cast<float>(i), 0.f);
+    }
+
+    // 注册前加入的tag在注册时导入
+    context.Add<ActiveTag>(entities[0]);
+    EXPECT_TRUE(context.IsTagRegistered<ActiveTag>());
+    context.GetCommandBuffer().Add<SelectTag>(entities[1]);
+    context.PlaybackCommands();
+    EXPECT_FALSE(context.IsTagRegistered<SelectTag>());
+    EXPECT_TRUE(context.Has<SelectTag>(entities[1]));
+    context.RegisterTags<SelectTag, DeadTag>();
+    EXPECT_TRUE(context.Has<SelectTag>(entities[1]));
+
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        if (i % 2 == 0)
+        {
+            context.AddOrRepalce<ActiveTag>(entities[i]);
+        }
+        if (i % 5 == 0)
+        {
+            context.Add<DeadTag>(entities[i]);
+        }
+    }
+    EXPECT_TRUE(context.Has<ActiveTag>(entities[4]));
+    EXPECT_FALSE(context.Has<ActiveTag>(entities[3]));
+    EXPECT_TRUE(context.GetTagMask(entities[10]).Test(GetTagBit<DeadTag>()));
+    EXPECT_TRUE(context.HasTags(entities[10], TagFilter(Include<ActiveTag, DeadTag>)));
+    EXPECT_FALSE(context.HasTags(entities[10], TagFilter(Include<ActiveTag>, Exclude<DeadTag>)));
+
+    // 位掩码过滤与entt的Include/Exclude结果一致
+    size_t expected = 0;
+    for (Entity entity : context.GetView<Position, ActiveTag>(ExcludeDeadTag))
+    {
+        EXPECT_EQ(entt::to_entity(entity) % 2, 0);
+        ++expected;
+    }
+    size_t count = 0;
+    context.Each(TagFilter(Include<ActiveTag>, ExcludeDeadTag), [&count](Entity entity)
+    {
+        EXPECT_EQ(entt::to_entity(entity) % 2, 0);
+        EXPECT_NE(entt::to_entity(entity) % 5, 0);
+        ++count;
+    });
+    EXPECT_EQ(count, expected);
+    EXPECT_EQ(count, 80);
+
+    count = 0;
+    context.Each<const Position>(TagFilter(ExcludeDeadTag), [&count](Entity entity, const Position& pos)
+    {
+        EXPECT_NE(static_cast<size_t>(pos.x) % 5, 0);
+        ++count;
+    });
+    EXPECT_EQ(count, 160);
+
+    // 移除和销毁后位被清除
+    context.Remove<ActiveTag>(entities[2]);
+    EXPECT_FALSE(context.Has<ActiveTag>(entities[2]));
+    const Entity destroyed = entities[4];
+    context.DestoryEntity(destroyed);
+    const Entity recycled = context.CreateEntity();
+    EXPECT_EQ(entt::to_entity(recycled), entt::to_entity(destroyed));
+    EXPECT_FALSE(context.Has<ActiveTag>(recycled));
+    EXPECT_TRUE(context.GetTagMask(recycled).Empty());
+
+    context.Clear();
+    EXPECT_FALSE(context.Has<ActiveTag>(entities[0]));
+}
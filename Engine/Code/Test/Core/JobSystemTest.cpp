@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include <EASTL/vector.h>
+#include <EASTL/unique_ptr.h>
+
+#include <Service/Service.h>
+#include <Jobs/JobSystem.h>
+#include <Jobs/WorkStealingDeque.h>
+
+using namespace Spark;
+
+class JobSystemTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {
+        JobSystemConfig config;
+        config.m_workerCount = 4;
+        jobSystem = eastl::make_unique<JobSystem>(config);
+        jobSystem->Initialize();
+    }
+
+    void TearDown() override {
+        jobSystem->ShutDown();
+        jobSystem.reset();
+    }
+
+    eastl::unique_ptr<JobSystem> jobSystem;
+};
+
+TEST_F(JobSystemTest, Service)
+{
+    EXPECT_EQ(Service<IJobSystem>::Get(), jobSystem.get());
+    EXPECT_EQ(jobSystem->GetWorkerCount(), 4);
+}
+
+TEST_F(JobSystemTest, Schedule)
+{
+    std::atomic<int> count {0};
+    eastl::vector<JobHandle> jobs;
+    for (int i = 0; i < 1000; ++i)
+    {
+        jobs.push_back(jobSystem->Schedule([&count]() { count.fetch_add(1); }));
+    }
+    for (auto& job : jobs)
+    {
+        jobSystem->Wait(job);
+        EXPECT_TRUE(job->IsFinished());
+    }
+    EXPECT_EQ(count.load(), 1000);
+}
+
+TEST_F(JobSystemTest, Dependency)
+{
+    eastl::vector<int> order;
+    std::atomic<int> running {0};
+    auto Record = [&](int id)
+    {
+        EXPECT_EQ(running.fetch_add(1), 0);
+        order.push_back(id);
+        running.fetch_sub(1);
+    };
+
+    // a -> b -> d, a -> c -> d
+    JobHandle a = jobSystem->CreateJob([&]() { Record(0); });
+    JobHandle b = jobSystem->CreateJob([&]() { Record(1); });
+    JobHandle c = jobSystem->CreateJob([&]() { Record(1); });
+    JobHandle d = jobSystem->CreateJob([&]() { Record(2); });
+    // b和c不会同时执行，因为c依赖b
+    jobSystem->AddDependency(b, a);
+    jobSystem->AddDependency(c, b);
+    jobSystem->AddDependency(d, b);
+    jobSystem->AddDependency(d, c);
+
+    jobSystem->Submit(d);
+    jobSystem->Submit(c);
+    jobSystem->Submit(b);
+    EXPECT_FALSE(d->IsFinished());
+    jobSystem->Submit(a);
+
+    jobSystem->Wait(d);
+    EXPECT_EQ(order, (eastl::vector<int>{0, 1, 1, 2}));
+
+    // 依赖已完成的任务立即执行
+    JobHandle e = jobSystem->Then(d, [&]() { Record(3); });
+    jobSystem->Wait(e);
+    EXPECT_EQ(order.back(), 3);
+}
+
+TEST_F(JobSystemTest, ParallelFor)
+{
+    const size_t count = 100000;
+    eastl::vector<std::atomic<int>> visited(count);
+    std::atomic<size_t> calls {0};
+    jobSystem->ParallelFor(0, count, [&](size_t first, size_t last)
+    {
+        EXPECT_LT(first, last);
+        calls.fetch_add(1);
+        for (size_t i = first; i < last; ++i)
+        {
+            visited[i].fetch_add(1, std::memory_order_relaxed);
+        }
+    }, 64);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(visited[i].load(), 1) << i;
+    }
+    // 分块大小不小于minGrain
+    EXPECT_LE(calls.load(), count / 64 + 1);
+
+    // 空范围不调用
+    jobSystem->ParallelFor(5, 5, [&](size_t, size_t) { FAIL(); });
+}
+
+TEST_F(JobSystemTest, NestedWait)
+{
+    // 等待中的任务会执行其他任务，不会因worker被占满而死锁
+    std::atomic<int> count {0};
+    eastl::vector<JobHandle> outer;
+    for (int i = 0; i < 16; ++i)
+    {
+        outer.push_back(jobSystem->Schedule([this, &count]()
+        {
+            jobSystem->ParallelFor(0, 1000, [&count](size_t first, size_t last)
+            {
+                count.fetch_add(static_cast<int>(last - first));
+            });
+
+            JobHandle inner = jobSystem->Schedule([&count]() { count.fetch_add(1); });
+            jobSystem->Wait(inner);
+        }));
+    }
+    for (auto& job : outer)
+    {
+        jobSystem->Wait(job);
+    }
+    EXPECT_EQ(count.load(), 16 * 1001);
+}
+
+TEST_F(JobSystemTest, WorkerStats)
+{
+    jobSystem->ResetWorkerStats();
+    jobSystem->ParallelFor(0, 1 << 16, [](size_t first, size_t last)
+    {
+        volatile size_t sum = 0;
+        for (size_t i = first; i < last; ++i)
+        {
+            sum += i;
+        }
+    });
+
+    auto stats = jobSystem->GetWorkerStats();
+    ASSERT_EQ(stats.size(), 4);
+    for (const auto& worker : stats)
+    {
+        EXPECT_GE(worker.m_utilization, 0.f);
+        EXPECT_LE(worker.m_utilization, 1.f);
+    }
+
+    jobSystem->ResetWorkerStats();
+    for (const auto& worker : jobSystem->GetWorkerStats())
+    {
+        EXPECT_EQ(worker.m_executedJobs, 0);
+        EXPECT_EQ(worker.m_stolenJobs, 0);
+    }
+}
+
+TEST(JobSystemNoWorkerTest, Inline)
+{
+    // 未初始化时任务在调用线程执行
+    JobSystem jobSystem;
+    int value = 0;
+    JobHandle job = jobSystem.Schedule([&value]() { value = 1; });
+    EXPECT_TRUE(job->IsFinished());
+    EXPECT_EQ(value, 1);
+
+    size_t sum = 0;
+    jobSystem.ParallelFor(0, 100, [&sum](size_t first, size_t last) { sum += last - first; });
+    EXPECT_EQ(sum, 100);
+}
+
+TEST(WorkStealingDequeTest, Steal)
+{
+    WorkStealingDeque<int*> deque(4);
+    const int count = 100000;
+    eastl::vector<int> values(count);
+    std::atomic<int> taken {0};
+    std::atomic<bool> done {false};
+
+    eastl::vector<std::thread> thieves;
+    for (int i = 0; i < 3; ++i)
+    {
+        thieves.emplace_back([&]()
+        {
+            int* value = nullptr;
+            while (!done.load() || !deque.Empty())
+            {
+                if (deque.Steal(value))
+                {
+                    ++*value;
+                    taken.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    // owner线程交替压入和弹出，缓冲区会多次扩容
+    int* value = nullptr;
+    for (int i = 0; i < count; ++i)
+    {
+        deque.Push(&values[i]);
+        if (i % 3 == 0 && deque.Pop(value))
+        {
+            ++*value;
+            taken.fetch_add(1);
+        }
+    }
+    while (deque.Pop(value))
+    {
+        ++*value;
+        taken.fetch_add(1);
+    }
+    done.store(true);
+    for (auto& thief : thieves)
+    {
+        thief.join();
+    }
+
+    EXPECT_EQ(taken.load(), count);
+    for (int i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(values[i], 1) << i;
+    }
+}
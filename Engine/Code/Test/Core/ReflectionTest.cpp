@@ -279,4 +279,23 @@ TEST(ReflectionTest, Custom)
     EXPECT_STREQ(fe.format.c_str(), "%.3f");
 
     EXPECT_NE(GetTypeId<A::Foo>(), GetTypeId<B::Foo>());
-}
\ No newline at end of file
+}
+
+TEST(ReflectionTest, TypeIndex)
+{
+    const uint32_t count = GetTypeIndexCount();
+    EXPECT_EQ(FindTypeIndex(GetTypeId<A::Foo>()), InvalidTypeIndex);
+
+    const TypeIndex first = GetTypeIndex<A::Foo>();
+    const TypeIndex second = GetTypeIndex<B::Foo>();
+    EXPECT_NE(first, second);
+    EXPECT_LT(first, GetTypeIndexCount());
+    EXPECT_LT(second, GetTypeIndexCount());
+    EXPECT_EQ(GetTypeIndexCount(), count + 2);
+
+    // 同一类型总是得到同一个索引
+    EXPECT_EQ(GetTypeIndex<A::Foo>(), first);
+    EXPECT_EQ(GetTypeIndex<const A::Foo>(), first);
+    EXPECT_EQ(FindTypeIndex(GetTypeId<A::Foo>()), first);
+    EXPECT_EQ(GetTypeIndexCount(), count + 2);
+}
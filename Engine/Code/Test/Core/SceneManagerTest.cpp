@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <EASTL/array.h>
 
+#include <atomic>
+
 #include <ECS/WorldContext.h>
 #include <ECS/Tag.h>
 #include <Service/Service.h>
@@ -9,6 +11,8 @@
 #include <SceneManager/Component/HierarchyComponent.h>
 #include <SceneManager/IScene.h>
 #include <SceneManager/SceneManager.h>
+#include <EntityReaper/EntityReaper.h>
+#include <Jobs/JobSystem.h>
 
 using namespace Spark;
 
@@ -441,3 +445,438 @@ TEST_F(SceneManagerTest, Patch)
 
 
 
+
+TEST_F(SceneManagerTest, EntityTree)
+{
+    eastl::array<Entity, 5> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    ASSERT_TRUE(Service<IScene>::Get());
+    auto scene = Service<IScene>::Get();
+    auto ent0 = entities[0];
+    auto ent1 = entities[1];
+    auto ent2 = entities[2];
+    auto ent3 = entities[3];
+    auto ent4 = entities[4];
+
+    auto CheckTree = [&](eastl::vector<eastl::pair<Entity, uint32_t>> expected)
+    {
+        eastl::vector<eastl::pair<Entity, uint32_t>> tree = scene->GetEntityTree();
+        ASSERT_EQ(tree.size(), expected.size());
+        for (size_t i = 0; i < tree.size(); ++i)
+        {
+            EXPECT_EQ(tree[i].first, expected[i].first);
+            EXPECT_EQ(tree[i].second, expected[i].second);
+        }
+    };
+
+    scene->SetParent(ent1, ent0);
+    scene->SetParent(ent2, ent1);
+    scene->SetParent(ent3, ent0, ent1);
+    CheckTree({{ent0, 0}, {ent1, 1}, {ent2, 2}, {ent3, 1}});
+
+    // 子树整体移动
+    scene->SetParent(ent3, ent1, ent2);
+    CheckTree({{ent0, 0}, {ent1, 1}, {ent2, 2}, {ent3, 2}});
+
+    // 子节点上升至父节点的父节点
+    scene->RemoveEntity(ent1);
+    CheckTree({{ent0, 0}, {ent2, 1}, {ent3, 1}});
+
+    scene->AddEntity(ent4);
+    CheckTree({{ent0, 0}, {ent2, 1}, {ent3, 1}, {ent4, 0}});
+
+    context.DestoryEntity(ent0);
+    CheckTree({{ent2, 0}, {ent3, 0}, {ent4, 0}});
+}
+
+TEST_F(SceneManagerTest, Batch)
+{
+    eastl::array<Entity, 5> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    ASSERT_TRUE(Service<IScene>::Get());
+    auto scene = Service<IScene>::Get();
+    auto ent0 = entities[0];
+    auto ent1 = entities[1];
+    auto ent2 = entities[2];
+    auto ent3 = entities[3];
+    auto ent4 = entities[4];
+
+    scene->AddEntities(entities);
+    EXPECT_FALSE(scene->IsInBatch());
+    EXPECT_EQ(scene->GetEntityCount(), 5);
+    EXPECT_EQ(scene->GetRootEntities().size(), 5);
+
+    {
+        SceneBatchScope batch(scene);
+        EXPECT_TRUE(scene->IsInBatch());
+        scene->SetParent(ent1, ent0);
+        scene->SetParent(ent2, ent0, ent1);
+        scene->SetParent(ent3, ent0, ent2);
+        scene->SetParent(ent4, ent3);
+
+        // 批处理结束前只记录事件
+        EXPECT_EQ(scene->GetRootEntities().size(), 5);
+        EXPECT_TRUE(scene->GetChildren(ent0).empty());
+        CheckHierarchy(context, ent0, NullEntity, NullEntity, NullEntity, NullEntity);
+    }
+    EXPECT_FALSE(scene->IsInBatch());
+    CheckHierarchy(context, ent0, NullEntity, ent1, NullEntity, NullEntity);
+    CheckHierarchy(context, ent1, ent0, NullEntity, NullEntity, ent2);
+    CheckHierarchy(context, ent3, ent0, ent4, ent2, NullEntity);
+    CheckHierarchy(context, ent4, ent3, NullEntity, NullEntity, NullEntity);
+
+    EXPECT_EQ(scene->GetRootEntities().size(), 1);
+    eastl::vector<Entity> children = scene->GetChildren(ent0);
+    ASSERT_EQ(children.size(), 3);
+    EXPECT_EQ(children[0], ent1);
+    EXPECT_EQ(children[1], ent2);
+    EXPECT_EQ(children[2], ent3);
+    EXPECT_EQ(scene->GetDepth(ent4), 2);
+    EXPECT_EQ(scene->GetEntityTree().size(), 5);
+
+    eastl::array<Entity, 2> removed {ent3, ent4};
+    scene->RemoveEntities(removed);
+    EXPECT_EQ(scene->GetEntityCount(), 3);
+    EXPECT_EQ(scene->GetChildren(ent0).size(), 2);
+    EXPECT_EQ(scene->GetEntityTree().size(), 3);
+
+    // 实例化的Hierarchy在同一个批处理中应用
+    Prefab prefab;
+    prefab.Set<Hierarchy>(Hierarchy{ent0});
+    eastl::vector<Entity> instances(100);
+    scene->Instantiate(prefab, instances.size(), instances);
+    EXPECT_FALSE(scene->IsInBatch());
+    EXPECT_EQ(scene->GetEntityCount(), 103);
+    EXPECT_EQ(scene->GetChildren(ent0).size(), 102);
+    EXPECT_EQ(scene->GetEntityRoot(instances.back()), ent0);
+}
+
+TEST_F(SceneManagerTest, BatchOrder)
+{
+    eastl::array<Entity, 5> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    auto scene = Service<IScene>::Get();
+    auto ent0 = entities[0];
+    auto ent1 = entities[1];
+    auto ent2 = entities[2];
+    auto ent3 = entities[3];
+    auto ent4 = entities[4];
+
+    // 先添加子节点，再添加父节点
+    {
+        SceneBatchScope batch(scene);
+        Hierarchy grandChild;
+        grandChild.parent = ent2;
+        context.Add<Hierarchy>(ent3, grandChild);
+        Hierarchy child;
+        child.parent = ent0;
+        context.Add<Hierarchy>(ent2, child);
+        Hierarchy sibling;
+        sibling.parent = ent0;
+        sibling.prevSibling = ent2;
+        context.Add<Hierarchy>(ent1, sibling);
+        context.Add<Hierarchy>(ent0);
+        EXPECT_FALSE(scene->Contain(ent0));
+    }
+    EXPECT_EQ(scene->GetEntityCount(), 4);
+    CheckHierarchy(context, ent0, NullEntity, ent2, NullEntity, NullEntity);
+    CheckHierarchy(context, ent2, ent0, ent3, NullEntity, ent1);
+    CheckHierarchy(context, ent1, ent0, NullEntity, ent2, NullEntity);
+    CheckHierarchy(context, ent3, ent2, NullEntity, NullEntity, NullEntity);
+    EXPECT_EQ(scene->GetDepth(ent3), 2);
+
+    // 没有prevSibling的实体成为第一个子节点，与逐个调用SetParent的结果相同
+    {
+        SceneBatchScope batch(scene);
+        scene->SetParent(ent4, ent0);
+        scene->SetParent(ent3, ent0);
+    }
+    eastl::vector<Entity> children = scene->GetChildren(ent0);
+    ASSERT_EQ(children.size(), 4);
+    EXPECT_EQ(children[0], ent3);
+    EXPECT_EQ(children[1], ent4);
+    EXPECT_EQ(children[2], ent2);
+    EXPECT_EQ(children[3], ent1);
+    EXPECT_TRUE(scene->GetChildren(ent2).empty());
+    EXPECT_EQ(scene->GetEntityTree().size(), 5);
+
+    // 同一批次中销毁父节点和子节点
+    {
+        SceneBatchScope batch(scene);
+        scene->SetParent(ent1, ent3);
+        context.DestoryEntity(ent0);
+        context.DestoryEntity(ent2);
+    }
+    EXPECT_EQ(scene->GetEntityCount(), 3);
+    EXPECT_EQ(scene->GetRootEntities().size(), 2);
+    CheckHierarchy(context, ent3, NullEntity, ent1, NullEntity, NullEntity);
+    CheckHierarchy(context, ent1, ent3, NullEntity, NullEntity, NullEntity);
+    CheckHierarchy(context, ent4, NullEntity, NullEntity, NullEntity, NullEntity);
+}
+
+TEST_F(SceneManagerTest, MoveSubtree)
+{
+    eastl::array<Entity, 6> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    auto scene = Service<IScene>::Get();
+    auto ent0 = entities[0];
+    auto ent1 = entities[1];
+    auto ent2 = entities[2];
+    auto ent3 = entities[3];
+    auto ent4 = entities[4];
+    auto ent5 = entities[5];
+
+    scene->SetParent(ent1, ent0);
+    scene->SetParent(ent2, ent0, ent1);
+    scene->SetParent(ent3, ent1);
+    scene->SetParent(ent4, ent1, ent3);
+    scene->AddEntity(ent5);
+
+    // 子树随实体移动，原来的兄弟节点留在原处
+    scene->SetParent(ent1, ent5);
+    CheckHierarchy(context, ent0, NullEntity, ent2, NullEntity, NullEntity);
+    CheckHierarchy(context, ent2, ent0, NullEntity, NullEntity, NullEntity);
+    CheckHierarchy(context, ent1, ent5, ent3, NullEntity, NullEntity);
+    EXPECT_EQ(scene->GetChildren(ent1).size(), 2);
+    EXPECT_EQ(scene->GetDepth(ent4), 2);
+    EXPECT_EQ(scene->GetEntityRoot(ent4), ent5);
+
+    // 移除第一个子节点，其子节点占据它的位置
+    scene->SetParent(ent1, ent0);
+    scene->RemoveEntity(ent1);
+    eastl::vector<Entity> children = scene->GetChildren(ent0);
+    ASSERT_EQ(children.size(), 3);
+    EXPECT_EQ(children[0], ent3);
+    EXPECT_EQ(children[1], ent4);
+    EXPECT_EQ(children[2], ent2);
+    CheckHierarchy(context, ent0, NullEntity, ent3, NullEntity, NullEntity);
+    CheckHierarchy(context, ent2, ent0, NullEntity, ent4, NullEntity);
+}
+
+TEST_F(SceneManagerTest, View)
+{
+    eastl::array<Entity, 5> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    ASSERT_TRUE(Service<IScene>::Get());
+    auto scene = Service<IScene>::Get();
+    auto ent0 = entities[0];
+    auto ent1 = entities[1];
+    auto ent2 = entities[2];
+    auto ent3 = entities[3];
+    auto ent4 = entities[4];
+
+    scene->SetParent(ent1, ent0);
+    scene->SetParent(ent2, ent0, ent1);
+    scene->SetParent(ent3, ent2);
+    scene->AddEntity(ent4);
+
+    auto roots = scene->GetRootEntitiesView();
+    EXPECT_EQ(roots.size(), 2);
+
+    auto children = scene->GetChildrenView(ent0);
+    ASSERT_EQ(children.size(), 2);
+    EXPECT_EQ(children[0], ent1);
+    EXPECT_EQ(children[1], ent2);
+    EXPECT_TRUE(scene->GetChildrenView(ent4).empty());
+
+    auto tree = scene->GetEntityTreeView();
+    ASSERT_EQ(tree.size(), 5);
+    EXPECT_EQ(tree[3].first, ent3);
+    EXPECT_EQ(tree[3].second, 2);
+
+    auto range = scene->GetEntityTreeRange(2, 2);
+    ASSERT_EQ(range.size(), 2);
+    EXPECT_EQ(range[0].first, ent2);
+    EXPECT_EQ(range[1].first, ent3);
+
+    EXPECT_EQ(scene->GetEntityTreeRange(3, 10).size(), 2);
+    EXPECT_TRUE(scene->GetEntityTreeRange(5, 1).empty());
+}
+
+TEST_F(SceneManagerTest, AncestorQuery)
+{
+    eastl::array<Entity, 5> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    ASSERT_TRUE(Service<IScene>::Get());
+    auto scene = Service<IScene>::Get();
+    auto ent0 = entities[0];
+    auto ent1 = entities[1];
+    auto ent2 = entities[2];
+    auto ent3 = entities[3];
+    auto ent4 = entities[4];
+
+    scene->SetParent(ent1, ent0);
+    scene->SetParent(ent2, ent1);
+    scene->SetParent(ent3, ent2);
+    scene->AddEntity(ent4);
+    EXPECT_TRUE(scene->IsAncestor(ent3, ent0));
+    EXPECT_FALSE(scene->IsAncestor(ent0, ent3));
+    EXPECT_FALSE(scene->IsAncestor(ent3, ent3));
+    EXPECT_EQ(scene->GetDepth(ent3), 3);
+    EXPECT_EQ(scene->GetEntityRoot(ent3), ent0);
+
+    // 子树移动后深度和根节点随之更新
+    scene->SetParent(ent2, ent4);
+    EXPECT_FALSE(scene->IsAncestor(ent3, ent0));
+    EXPECT_TRUE(scene->IsAncestor(ent3, ent4));
+    EXPECT_EQ(scene->GetDepth(ent3), 2);
+    EXPECT_EQ(scene->GetEntityRoot(ent3), ent4);
+    eastl::vector<Entity> path = scene->GetHierarchyPath(ent3);
+    ASSERT_EQ(path.size(), 2);
+    EXPECT_EQ(path[0], ent4);
+    EXPECT_EQ(path[1], ent2);
+
+    // 移除根节点，子节点成为新的根
+    scene->RemoveEntity(ent4);
+    EXPECT_EQ(scene->GetDepth(ent3), 1);
+    EXPECT_EQ(scene->GetEntityRoot(ent3), ent2);
+    EXPECT_EQ(scene->GetEntityRoot(ent1), ent0);
+    EXPECT_TRUE(scene->GetHierarchyPath(ent2).empty());
+}
+
+TEST_F(SceneManagerTest, ManySiblings)
+{
+    // 逐个追加大量子节点和根节点，顺序和祖先查询保持正确
+    const size_t count = 20000;
+    eastl::vector<Entity> roots(count);
+    eastl::vector<Entity> children(count);
+    context.CreateEntity(roots.begin(), roots.end());
+    context.CreateEntity(children.begin(), children.end());
+    auto scene = Service<IScene>::Get();
+
+    for (Entity root : roots)
+    {
+        scene->AddEntity(root);
+    }
+    Entity prev = NullEntity;
+    for (Entity child : children)
+    {
+        scene->SetParent(child, roots[0], prev);
+        prev = child;
+    }
+
+    auto view = scene->GetChildrenView(roots[0]);
+    ASSERT_EQ(view.size(), count);
+    for (size_t i = 0; i < count; i += 997)
+    {
+        EXPECT_EQ(view[i], children[i]);
+    }
+    EXPECT_TRUE(scene->IsAncestor(children.back(), roots[0]));
+    EXPECT_FALSE(scene->IsAncestor(children.back(), roots[1]));
+    EXPECT_FALSE(scene->IsAncestor(roots.back(), roots[0]));
+
+    // 插到开头和中间
+    scene->SetParent(roots.back(), roots[0]);
+    scene->SetParent(roots[count - 2], roots[0], children[count / 2]);
+    view = scene->GetChildrenView(roots[0]);
+    ASSERT_EQ(view.size(), count + 2);
+    EXPECT_EQ(view[0], roots.back());
+    EXPECT_EQ(view[count / 2 + 2], roots[count - 2]);
+    EXPECT_TRUE(scene->IsAncestor(roots[count - 2], roots[0]));
+
+    scene->RemoveEntity(children[0]);
+    EXPECT_EQ(scene->GetChildrenView(roots[0]).size(), count + 1);
+    EXPECT_EQ(scene->GetEntityTreeView().size(), 2 * count - 1);
+}
+
+TEST_F(SceneManagerTest, SubtreeTraversal)
+{
+    eastl::array<Entity, 5> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    ASSERT_TRUE(Service<IScene>::Get());
+    auto scene = Service<IScene>::Get();
+    auto ent0 = entities[0];
+    auto ent1 = entities[1];
+    auto ent2 = entities[2];
+    auto ent3 = entities[3];
+    auto ent4 = entities[4];
+
+    scene->SetParent(ent1, ent0);
+    scene->SetParent(ent2, ent1);
+    scene->SetParent(ent3, ent0, ent1);
+    scene->AddEntity(ent4);
+
+    eastl::vector<Entity> visited;
+    scene->ForEachInSubtree(ent1, [&](Entity entity){
+        visited.push_back(entity);
+    });
+    ASSERT_EQ(visited.size(), 2);
+    EXPECT_EQ(visited[0], ent1);
+    EXPECT_EQ(visited[1], ent2);
+
+    EXPECT_EQ(scene->GetSubtreeView(ent0).size(), 4);
+    EXPECT_EQ(scene->GetSubtreeView(ent4).size(), 1);
+
+    eastl::vector<Entity> many(4096);
+    context.CreateEntity(many.begin(), many.end());
+    for (Entity entity: many)
+    {
+        scene->SetParent(entity, ent4);
+    }
+
+    std::atomic<size_t> count {0};
+    scene->ParallelForEachInSubtree(ent4, [&](Entity entity){
+        count.fetch_add(1, std::memory_order_relaxed);
+    }, 256);
+    EXPECT_EQ(count.load(), many.size() + 1);
+
+    JobSystem jobSystem;
+    jobSystem.Initialize();
+    count = 0;
+    scene->ParallelForEachInSubtree(ent4, [&](Entity entity){
+        count.fetch_add(1, std::memory_order_relaxed);
+    }, 256);
+    EXPECT_EQ(count.load(), many.size() + 1);
+    jobSystem.ShutDown();
+}
+
+TEST_F(SceneManagerTest, ReaperSubtree)
+{
+    eastl::array<Entity, 5> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    ASSERT_TRUE(Service<IScene>::Get());
+    auto scene = Service<IScene>::Get();
+    auto ent0 = entities[0];
+    auto ent1 = entities[1];
+    auto ent2 = entities[2];
+    auto ent3 = entities[3];
+    auto ent4 = entities[4];
+
+    scene->SetParent(ent1, ent0);
+    scene->SetParent(ent2, ent1);
+    scene->SetParent(ent3, ent0, ent1);
+    scene->AddEntity(ent4);
+
+    EntityReaperConfig config;
+    config.m_destroySubtree = true;
+    config.m_maxDestroyPerTick = 1;
+    EntityReaper reaper(config);
+
+    context.Add<DeadTag>(ent1);
+    reaper.OnTick(context, 0.f);
+    // 子节点先于父节点销毁
+    EXPECT_FALSE(context.Valid(ent2));
+    EXPECT_TRUE(context.Valid(ent1));
+    EXPECT_EQ(reaper.GetPendingCount(), 1);
+
+    // 已入队的实体不会重复入队，新标记的实体排在后面
+    context.Add<DeadTag>(ent4);
+    reaper.OnTick(context, 0.f);
+    EXPECT_FALSE(context.Valid(ent1));
+    EXPECT_TRUE(context.Valid(ent4));
+    EXPECT_EQ(reaper.GetPendingCount(), 1);
+    EXPECT_EQ(scene->GetChildren(ent0).size(), 1);
+
+    reaper.OnTick(context, 0.f);
+    EXPECT_FALSE(context.Valid(ent4));
+    EXPECT_EQ(reaper.GetPendingCount(), 0);
+    EXPECT_EQ(scene->GetEntityCount(), 2);
+
+    config.m_maxDestroyPerTick = 0;
+    EntityReaper unlimited(config);
+    context.Add<DeadTag>(ent0);
+    unlimited.OnTick(context, 0.f);
+    EXPECT_FALSE(context.Valid(ent0));
+    EXPECT_FALSE(context.Valid(ent3));
+    EXPECT_EQ(scene->GetEntityCount(), 0);
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <EASTL/vector.h>
+
+#include <ECS/WorldContext.h>
+#include <ECS/SoAStorage.h>
+
+using namespace Spark;
+
+struct SoAPosition
+{
+    float x;
+    float y;
+    float z;
+};
+
+struct SoAVelocity
+{
+    float x;
+    float y;
+    float z;
+};
+
+struct AoSPosition
+{
+    float x;
+    float y;
+    float z;
+};
+
+struct AoSVelocity
+{
+    float x;
+    float y;
+    float z;
+};
+
+namespace Spark
+{
+    template<>
+    struct SoATraits<SoAPosition> : SoAFields<&SoAPosition::x, &SoAPosition::y, &SoAPosition::z> {};
+
+    template<>
+    struct SoATraits<SoAVelocity> : SoAFields<&SoAVelocity::x, &SoAVelocity::y, &SoAVelocity::z> {};
+}
+
+TEST(SoAStorageTest, Storage)
+{
+    WorldContext context;
+    eastl::vector<Entity> entities(100);
+    context.CreateEntity(entities.begin(), entities.end());
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        context.AddSoA<SoAPosition>(entities[i], float(i), float(i) * 2.f, float(i) * 3.f);
+    }
+
+    SoAStorage<SoAPosition>& storage = context.GetSoAStorage<SoAPosition>();
+    ASSERT_EQ(storage.Size(), 100);
+    EXPECT_EQ(storage.AlignedSize(), 112);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(storage.Stream<0>()) % SoAStorage<SoAPosition>::Alignment, 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(storage.StreamOf<&SoAPosition::z>()) % SoAStorage<SoAPosition>::Alignment, 0);
+    EXPECT_EQ(storage.StreamOf<&SoAPosition::y>(), storage.Stream<1>());
+
+    // 第i个元素属于Entities()[i]
+    for (size_t i = 0; i < storage.Size(); ++i)
+    {
+        const Entity entity = storage.Entities()[i];
+        EXPECT_EQ(storage.IndexOf(entity), i);
+        EXPECT_FLOAT_EQ(storage.Stream<1>()[i], context.GetSoA<SoAPosition>(entity).x * 2.f);
+    }
+
+    // 删除时最后一个元素移到空位
+    context.RemoveSoA<SoAPosition>(entities[10]);
+    EXPECT_FALSE(context.HasSoA<SoAPosition>(entities[10]));
+    EXPECT_EQ(storage.Size(), 99);
+    EXPECT_EQ(storage.Entities()[10], entities[99]);
+    EXPECT_FLOAT_EQ(storage.Stream<2>()[10], 297.f);
+
+    context.AddSoA<SoAPosition>(entities[0], SoAPosition{-1.f, -2.f, -3.f});
+    EXPECT_EQ(storage.Size(), 99);
+    EXPECT_FLOAT_EQ(context.GetSoA<SoAPosition>(entities[0]).z, -3.f);
+
+    // 销毁实体时移除组件
+    context.DestoryEntity(entities[0]);
+    EXPECT_EQ(storage.Size(), 98);
+    EXPECT_FALSE(context.HasSoA<SoAPosition>(entities[0]));
+    EXPECT_FALSE(context.HasSoA<SoAVelocity>(entities[1]));
+
+    context.Clear();
+    EXPECT_TRUE(storage.Empty());
+}
+
+TEST(SoAStorageTest, MatchOrder)
+{
+    WorldContext context;
+    eastl::vector<Entity> entities(50);
+    context.CreateEntity(entities.begin(), entities.end());
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        context.AddSoA<SoAPosition>(entities[i], float(i), 0.f, 0.f);
+    }
+    // 按相反顺序加入速度
+    for (size_t i = entities.size(); i-- > 0;)
+    {
+        context.AddSoA<SoAVelocity>(entities[i], float(i), 0.f, 0.f);
+    }
+
+    auto& positions = context.GetSoAStorage<SoAPosition>();
+    auto& velocities = context.GetSoAStorage<SoAVelocity>();
+    velocities.MatchOrder(positions);
+    for (size_t i = 0; i < positions.Size(); ++i)
+    {
+        ASSERT_EQ(velocities.Entities()[i], positions.Entities()[i]);
+        ASSERT_EQ(velocities.IndexOf(positions.Entities()[i]), i);
+        EXPECT_FLOAT_EQ(velocities.Stream<0>()[i], positions.Stream<0>()[i]);
+    }
+}
+
+namespace
+{
+    // pos += vel * dt，按8个float一组处理，数组按Lanes补齐所以没有尾部
+    void Integrate(float* position, const float* velocity, size_t alignedSize, float dt)
+    {
+#if defined(__AVX2__)
+        const __m256 delta = _mm256_set1_ps(dt);
+        for (size_t i = 0; i < alignedSize; i += 8)
+        {
+            __m256 p = _mm256_load_ps(position + i);
+            const __m256 v = _mm256_load_ps(velocity + i);
+            p = _mm256_add_ps(p, _mm256_mul_ps(v, delta));
+            _mm256_store_ps(position + i, p);
+        }
+#else
+        for (size_t i = 0; i < alignedSize; ++i)
+        {
+            position[i] += velocity[i] * dt;
+        }
+#endif
+    }
+
+    template<typename Func>
+    double MeasureMilliseconds(int iterations, Func&& func)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            func();
+        }
+        const std::chrono::duration<double, std::milli> span = std::chrono::steady_clock::now() - start;
+        return span.count() / iterations;
+    }
+}
+
+// 计时对比，不作为单元测试运行，使用--gtest_also_run_disabled_tests手动运行
+TEST(SoAStorageTest, DISABLED_Benchmark)
+{
+    const size_t count = 1 << 18;
+    const int iterations = 20;
+    const float dt = 1.f / 60.f;
+
+    WorldContext context;
+    eastl::vector<Entity> entities(count);
+    context.CreateEntity(entities.begin(), entities.end());
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float value = static_cast<float>(i % 1024);
+        context.Add<AoSPosition>(entities[i], value, value, value);
+        context.Add<AoSVelocity>(entities[i], 1.f, 2.f, 3.f);
+        context.AddSoA<SoAPosition>(entities[i], value, value, value);
+        context.AddSoA<SoAVelocity>(entities[i], 1.f, 2.f, 3.f);
+    }
+
+    auto view = context.GetView<AoSPosition, const AoSVelocity>();
+    const double aosTime = MeasureMilliseconds(iterations, [&view, dt]()
+    {
+        view.each([dt](AoSPosition& pos, const AoSVelocity& vel)
+        {
+            pos.x += vel.x * dt;
+            pos.y += vel.y * dt;
+            pos.z += vel.z * dt;
+        });
+    });
+
+    auto& positions = context.GetSoAStorage<SoAPosition>();
+    auto& velocities = context.GetSoAStorage<SoAVelocity>();
+    velocities.MatchOrder(positions);
+    const double soaTime = MeasureMilliseconds(iterations, [&positions, &velocities, dt]()
+    {
+        const size_t size = positions.AlignedSize();
+        Integrate(positions.Stream<0>(), velocities.Stream<0>(), size, dt);
+        Integrate(positions.Stream<1>(), velocities.Stream<1>(), size, dt);
+        Integrate(positions.Stream<2>(), velocities.Stream<2>(), size, dt);
+    });
+
+    std::cout << "[SoAStorageTest] " << count << " entities, AoS view: " << aosTime << " ms, SoA streams: "
+              << soaTime << " ms" << std::endl;
+
+    // 两种存储的结果一致
+    for (size_t i = 0; i < count; i += 97)
+    {
+        const AoSPosition& aos = context.Get<AoSPosition>(entities[i]);
+        const SoAPosition soa = context.GetSoA<SoAPosition>(entities[i]);
+        ASSERT_NEAR(aos.x, soa.x, 1e-3f) << i;
+        ASSERT_NEAR(aos.y, soa.y, 1e-3f) << i;
+        ASSERT_NEAR(aos.z, soa.z, 1e-3f) << i;
+    }
+}
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <EASTL/vector.h>
+
+#include <ECS/WorldContext.h>
+#include <Tick/SystemScheduler.h>
+#include <Jobs/JobSystem.h>
+
+using namespace Spark;
+
+namespace
+{
+    struct CompA { int value = 0; };
+    struct CompB { int value = 0; };
+
+    struct TickRecord
+    {
+        std::mutex            mutex;
+        eastl::vector<int>    order;
+        std::atomic<int>      running {0};
+        std::atomic<int>      maxRunning {0};
+        std::atomic<int>      started {0};
+    };
+
+    class TestTickHandler : public ISystem,
+                            public TickBus::Handler
+    {
+    public:
+        enum class Mode { Exclusive, ReadA, WriteA, WriteB, Empty };
+
+        TestTickHandler(TickRecord& record, int id, unsigned int order, Mode mode, HashString name,
+                        eastl::vector<HashString> requests = {})
+            : m_record(record), m_id(id), m_order(order), m_mode(mode), m_name(name), m_requests(eastl::move(requests))
+        {
+            TickBus::Handler::BusConnect();
+        }
+
+        ~TestTickHandler()
+        {
+            TickBus::Handler::BusDisconnect();
+        }
+
+        void Initialize() override {}
+        void ShutDown() override {}
+        eastl::vector<HashString> Request() const override { return m_requests; }
+        HashString GetName() const override { return m_name; }
+
+        unsigned int GetTickOrder() const override { return m_order; }
+
+        void GetTickAccess(SystemAccess& access) const override
+        {
+            switch (m_mode)
+            {
+            case Mode::ReadA:  access.Read<CompA>(); break;
+            case Mode::WriteA: access.Write<CompA>(); break;
+            case Mode::WriteB: access.Write<CompB>(); break;
+            case Mode::Empty:  access.Read<>(); break;
+            default: break;
+            }
+        }
+
+        void OnTick(WorldContext& context, float deltaTime) override
+        {
+            const int running = ++m_record.running;
+            int expected = m_record.maxRunning.load();
+            while (running > expected && !m_record.maxRunning.compare_exchange_weak(expected, running)) {}
+
+            ++m_record.started;
+            threadId = std::this_thread::get_id();
+            if (m_waitOthers > 0)
+            {
+                // 等待其他处理器开始执行，超时说明没有并行
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+                while (m_record.started < m_waitOthers && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            if (m_work.count() > 0)
+            {
+                std::this_thread::sleep_for(m_work);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_record.mutex);
+                m_record.order.push_back(m_id);
+            }
+            --m_record.running;
+        }
+
+        void WaitOthers(int count) { m_waitOthers = count; }
+
+        // 持续执行一段时间，允许并行的处理器会与它重叠
+        void Work(std::chrono::microseconds duration) { m_work = duration; }
+
+        std::thread::id threadId;
+
+    private:
+        TickRecord&               m_record;
+        int                       m_id;
+        unsigned int              m_order;
+        Mode                      m_mode;
+        HashString                m_name;
+        eastl::vector<HashString> m_requests;
+        int                       m_waitOthers {0};
+        std::chrono::microseconds m_work {0};
+    };
+}
+
+class SystemSchedulerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {
+        JobSystemConfig config;
+        config.m_workerCount = 3;
+        jobSystem = eastl::make_unique<JobSystem>(config);
+        jobSystem->Initialize();
+        scheduler = eastl::make_unique<SystemScheduler>();
+        scheduler->Initialize();
+    }
+
+    void TearDown() override {
+        scheduler->ShutDown();
+        scheduler.reset();
+        if (jobSystem)
+        {
+            jobSystem->ShutDown();
+            jobSystem.reset();
+        }
+        context.Clear();
+    }
+
+    eastl::unique_ptr<JobSystem> jobSystem;
+    eastl::unique_ptr<SystemScheduler> scheduler;
+    WorldContext context;
+};
+
+TEST_F(SystemSchedulerTest, Serial)
+{
+    TickRecord record;
+    TestTickHandler h0(record, 0, 10, TestTickHandler::Mode::WriteA, "H0"_hs);
+    TestTickHandler h1(record, 1, 20, TestTickHandler::Mode::WriteB, "H1"_hs);
+    TestTickHandler h2(record, 2, 5, TestTickHandler::Mode::Exclusive, "H2"_hs);
+
+    scheduler->SetMode(ScheduleMode::Serial);
+    EXPECT_EQ(scheduler->GetMode(), ScheduleMode::Serial);
+    scheduler->Tick(context, 0.f);
+    EXPECT_EQ(record.order, (eastl::vector<int>{2, 0, 1}));
+    EXPECT_EQ(record.maxRunning, 1);
+    EXPECT_EQ(h0.threadId, std::this_thread::get_id());
+    EXPECT_EQ(h1.threadId, std::this_thread::get_id());
+}
+
+TEST_F(SystemSchedulerTest, Parallel)
+{
+    ASSERT_EQ(jobSystem->GetWorkerCount(), 3);
+
+    TickRecord record;
+    TestTickHandler h0(record, 0, 10, TestTickHandler::Mode::WriteA, "H0"_hs);
+    TestTickHandler h1(record, 1, 20, TestTickHandler::Mode::WriteB, "H1"_hs);
+    TestTickHandler h2(record, 2, 30, TestTickHandler::Mode::Empty, "H2"_hs);
+    h0.WaitOthers(3);
+    h1.WaitOthers(3);
+    h2.WaitOthers(3);
+
+    scheduler->Tick(context, 0.f);
+    EXPECT_EQ(record.order.size(), 3);
+    EXPECT_EQ(record.maxRunning, 3);
+}
+
+TEST_F(SystemSchedulerTest, Conflict)
+{
+    TickRecord record;
+    TestTickHandler h0(record, 0, 10, TestTickHandler::Mode::WriteA, "H0"_hs);
+    TestTickHandler h1(record, 1, 20, TestTickHandler::Mode::ReadA, "H1"_hs);
+    TestTickHandler h2(record, 2, 30, TestTickHandler::Mode::WriteA, "H2"_hs);
+    // 每个处理器执行一段时间，冲突的处理器若被并行调度会同时运行
+    h0.Work(std::chrono::microseconds(500));
+    h1.Work(std::chrono::microseconds(500));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        record.order.clear();
+        record.started = 0;
+        scheduler->Tick(context, 0.f);
+        EXPECT_EQ(record.started, 3);
+        EXPECT_EQ(record.order, (eastl::vector<int>{0, 1, 2}));
+    }
+    EXPECT_EQ(record.maxRunning, 1);
+}
+
+TEST_F(SystemSchedulerTest, Exclusive)
+{
+    TickRecord record;
+    TestTickHandler h0(record, 0, 10, TestTickHandler::Mode::WriteA, "H0"_hs);
+    TestTickHandler h1(record, 1, 20, TestTickHandler::Mode::Exclusive, "H1"_hs);
+    TestTickHandler h2(record, 2, 30, TestTickHandler::Mode::WriteB, "H2"_hs);
+
+    scheduler->Tick(context, 0.f);
+    EXPECT_EQ(record.order, (eastl::vector<int>{0, 1, 2}));
+    EXPECT_EQ(record.maxRunning, 1);
+    // 独占处理器在调用线程执行
+    EXPECT_EQ(h1.threadId, std::this_thread::get_id());
+}
+
+TEST_F(SystemSchedulerTest, Request)
+{
+    TickRecord record;
+    TestTickHandler h0(record, 0, 10, TestTickHandler::Mode::WriteA, "H0"_hs);
+    TestTickHandler h1(record, 1, 20, TestTickHandler::Mode::WriteB, "H1"_hs, {"H0"_hs});
+    // 依赖排在后面的系统时同样不会并行，但可以与H0并行
+    TestTickHandler h2(record, 2, 5, TestTickHandler::Mode::Empty, "H2"_hs, {"H1"_hs});
+    h0.WaitOthers(2);
+    h2.WaitOthers(2);
+
+    scheduler->Tick(context, 0.f);
+    ASSERT_EQ(record.order.size(), 3);
+    EXPECT_EQ(record.order.back(), 1);
+    EXPECT_EQ(record.maxRunning, 2);
+}
+
+TEST_F(SystemSchedulerTest, NoJobSystem)
+{
+    // 没有任务系统时串行执行
+    jobSystem->ShutDown();
+    jobSystem.reset();
+    ASSERT_EQ(Service<IJobSystem>::Get(), nullptr);
+
+    TickRecord record;
+    TestTickHandler h0(record, 0, 10, TestTickHandler::Mode::WriteA, "H0"_hs);
+    TestTickHandler h1(record, 1, 20, TestTickHandler::Mode::WriteB, "H1"_hs);
+    scheduler->Tick(context, 0.f);
+    EXPECT_EQ(record.order, (eastl::vector<int>{0, 1}));
+    EXPECT_EQ(h1.threadId, std::this_thread::get_id());
+}
@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include <EASTL/array.h>
+#include <chrono>
+#include <iostream>
+
+#include <ECS/WorldContext.h>
+#include <Service/Service.h>
+
+#include <SceneManager/IScene.h>
+#include <SceneManager/SceneManager.h>
+#include <Transform/TransformSystem.h>
+#include <Jobs/JobSystem.h>
+
+using namespace Spark;
+
+class TransformTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {
+        sceneManager = eastl::make_unique<SceneManager>(context);
+        sceneManager->Initialize();
+        transformSystem = eastl::make_unique<TransformSystem>(context);
+        transformSystem->Initialize();
+    }
+
+    void TearDown() override {
+        transformSystem->ShutDown();
+        transformSystem.reset();
+        sceneManager->ShutDown();
+        sceneManager.reset();
+        context.Clear();
+    }
+
+    Math::Vector3 WorldPosition(Entity entity)
+    {
+        return Math::Vector3(context.Get<WorldTransform>(entity).matrix[3]);
+    }
+
+    eastl::unique_ptr<SceneManager> sceneManager;
+    eastl::unique_ptr<TransformSystem> transformSystem;
+    WorldContext context;
+};
+
+TEST_F(TransformTest, Propagate)
+{
+    eastl::array<Entity, 3> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    auto scene = Service<IScene>::Get();
+    ASSERT_TRUE(scene);
+    auto ent0 = entities[0];
+    auto ent1 = entities[1];
+    auto ent2 = entities[2];
+
+    scene->SetParent(ent1, ent0);
+    scene->SetParent(ent2, ent1);
+    context.Add<LocalTransform>(ent0, LocalTransform{Math::Vector3(1.f, 0.f, 0.f)});
+    context.Add<LocalTransform>(ent2, LocalTransform{Math::Vector3(0.f, 2.f, 0.f)});
+
+    transformSystem->UpdateTransforms();
+    // WorldTransform在同步点添加
+    EXPECT_FALSE(context.Has<WorldTransform>(ent0));
+    context.PlaybackCommands();
+    ASSERT_TRUE(context.Has<WorldTransform>(ent0));
+    EXPECT_FALSE(context.Has<WorldTransform>(ent1));
+    EXPECT_EQ(WorldPosition(ent0), Math::Vector3(1.f, 0.f, 0.f));
+    EXPECT_EQ(WorldPosition(ent2), Math::Vector3(1.f, 2.f, 0.f));
+
+    // 父节点改变后子树随之更新
+    context.Repalce<LocalTransform>(ent0, LocalTransform{Math::Vector3(3.f, 0.f, 0.f), Math::QuaternionConst::IDENTITY, Math::Vector3(2.f)});
+    transformSystem->UpdateTransforms();
+    EXPECT_EQ(WorldPosition(ent2), Math::Vector3(3.f, 4.f, 0.f));
+
+    // 移除组件会移动存储中的其他组件，结果仍写入正确的实体
+    context.Remove<WorldTransform>(ent0);
+    context.Repalce<LocalTransform>(ent0, LocalTransform{Math::Vector3(5.f, 0.f, 0.f)});
+    transformSystem->UpdateTransforms();
+    EXPECT_FALSE(context.Has<WorldTransform>(ent0));
+    EXPECT_EQ(WorldPosition(ent2), Math::Vector3(5.f, 2.f, 0.f));
+
+    // 改变父子关系
+    scene->RemoveEntity(ent0);
+    transformSystem->UpdateTransforms();
+    EXPECT_EQ(WorldPosition(ent2), Math::Vector3(0.f, 2.f, 0.f));
+}
+
+TEST_F(TransformTest, Parallel)
+{
+    // 足够多的根节点使更新分配到多个线程
+    JobSystem jobSystem;
+    jobSystem.Initialize();
+    eastl::vector<Entity> roots(64 * 1024);
+    context.CreateEntity(roots.begin(), roots.end());
+    for (size_t i = 0; i < roots.size(); ++i)
+    {
+        context.Add<LocalTransform>(roots[i], LocalTransform{Math::Vector3(float(i), 0.f, 0.f)});
+    }
+    Service<IScene>::Get()->AddEntities(roots);
+
+    Entity child = context.CreateEntity();
+    Service<IScene>::Get()->SetParent(child, roots.back());
+    context.Add<LocalTransform>(child, LocalTransform{Math::Vector3(0.f, 1.f, 0.f)});
+
+    transformSystem->UpdateTransforms();
+    context.PlaybackCommands();
+    for (size_t i = 0; i < roots.size(); i += 1024)
+    {
+        EXPECT_EQ(WorldPosition(roots[i]).x, float(i));
+    }
+    EXPECT_EQ(WorldPosition(child), Math::Vector3(float(roots.size() - 1), 1.f, 0.f));
+    jobSystem.ShutDown();
+}
+
+TEST_F(TransformTest, Reparent)
+{
+    eastl::array<Entity, 5> entities;
+    context.CreateEntity(entities.begin(), entities.end());
+    auto scene = Service<IScene>::Get();
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        context.Add<LocalTransform>(entities[i], LocalTransform{Math::Vector3(float(i + 1), 0.f, 0.f)});
+    }
+    // ent0 -> ent1 -> ent2, ent3 -> ent4
+    scene->SetParent(entities[1], entities[0]);
+    scene->SetParent(entities[2], entities[1]);
+    scene->SetParent(entities[4], entities[3]);
+    transformSystem->UpdateTransforms();
+    context.PlaybackCommands();
+    EXPECT_EQ(WorldPosition(entities[2]), Math::Vector3(6.f, 0.f, 0.f));
+    EXPECT_EQ(WorldPosition(entities[4]), Math::Vector3(9.f, 0.f, 0.f));
+
+    // 子树移动到另一棵树
+    scene->SetParent(entities[1], entities[3]);
+    transformSystem->UpdateTransforms();
+    EXPECT_EQ(WorldPosition(entities[2]), Math::Vector3(9.f, 0.f, 0.f));
+    EXPECT_EQ(WorldPosition(entities[0]), Math::Vector3(1.f, 0.f, 0.f));
+
+    // 根节点成为子节点后，其子树随新的父节点更新
+    scene->SetParent(entities[3], entities[0]);
+    transformSystem->UpdateTransforms();
+    EXPECT_EQ(WorldPosition(entities[4]), Math::Vector3(10.f, 0.f, 0.f));
+    context.Repalce<LocalTransform>(entities[0], LocalTransform{Math::Vector3(0.f, 1.f, 0.f)});
+    transformSystem->UpdateTransforms();
+    EXPECT_EQ(WorldPosition(entities[2]), Math::Vector3(9.f, 1.f, 0.f));
+
+    // 销毁实体后其子节点上升到它的父节点下
+    context.DestoryEntity(entities[3]);
+    transformSystem->UpdateTransforms();
+    EXPECT_EQ(WorldPosition(entities[4]), Math::Vector3(5.f, 1.f, 0.f));
+    EXPECT_EQ(WorldPosition(entities[2]), Math::Vector3(5.f, 1.f, 0.f));
+
+    // 反复移动留下的空位被整体重建回收
+    for (int i = 0; i < 8; ++i)
+    {
+        scene->SetParent(entities[2], entities[i % 2 == 0 ? 0 : 4]);
+        transformSystem->UpdateTransforms();
+    }
+    EXPECT_EQ(WorldPosition(entities[2]), Math::Vector3(8.f, 1.f, 0.f));
+}
+
+// 计时对比，不作为单元测试运行，使用--gtest_also_run_disabled_tests手动运行
+TEST_F(TransformTest, DISABLED_Benchmark)
+{
+    // 500k个节点：5000棵树，每棵树一个根节点和99个子节点
+    const size_t rootCount = 5000;
+    const size_t childCount = 99;
+    JobSystem jobSystem;
+    jobSystem.Initialize();
+    auto scene = Service<IScene>::Get();
+
+    eastl::vector<Entity> roots(rootCount);
+    eastl::vector<Entity> children(rootCount * childCount);
+    context.CreateEntity(roots.begin(), roots.end());
+    context.CreateEntity(children.begin(), children.end());
+    scene->AddEntities(roots);
+    {
+        SceneBatchScope batch(scene);
+        for (size_t i = 0; i < children.size(); ++i)
+        {
+            scene->SetParent(children[i], roots[i / childCount]);
+        }
+    }
+    for (size_t i = 0; i < rootCount; ++i)
+    {
+        context.Add<LocalTransform>(roots[i], LocalTransform{Math::Vector3(float(i), 0.f, 0.f)});
+    }
+    for (Entity child : children)
+    {
+        context.Add<LocalTransform>(child, LocalTransform{Math::Vector3(0.f, 1.f, 0.f)});
+    }
+
+    auto measure = [this]()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        transformSystem->UpdateTransforms();
+        const std::chrono::duration<double, std::milli> span = std::chrono::steady_clock::now() - start;
+        return span.count();
+    };
+
+    const double buildTime = measure();
+    context.PlaybackCommands();
+
+    // 新增的WorldTransform使存储按节点顺序重新排序
+    const double sortTime = measure();
+
+    // 所有根节点移动，全部节点重新计算
+    for (size_t i = 0; i < rootCount; ++i)
+    {
+        context.Repalce<LocalTransform>(roots[i], LocalTransform{Math::Vector3(float(i), 2.f, 0.f)});
+    }
+    const double propagateTime = measure();
+
+    // 只有一棵子树改变父节点，其他子树不重新计算
+    scene->SetParent(children[0], roots[1]);
+    const double reparentTime = measure();
+
+    std::cout << "[TransformTest] " << roots.size() + children.size() << " entities, build: " << buildTime
+              << " ms, sort: " << sortTime << " ms, propagate all: " << propagateTime << " ms, reparent one: " << reparentTime << " ms" << std::endl;
+
+    EXPECT_EQ(WorldPosition(children.back()), Math::Vector3(float(rootCount - 1), 3.f, 0.f));
+    EXPECT_EQ(WorldPosition(children[0]), Math::Vector3(1.f, 3.f, 0.f));
+    EXPECT_LT(reparentTime, propagateTime);
+    jobSystem.ShutDown();
+}